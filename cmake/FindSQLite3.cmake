@@ -0,0 +1,31 @@
+# CMake module to search for SQLite3
+#
+# Once done this will define
+#
+#  SQLITE3_FOUND - system has the sqlite3 library
+#  SQLITE3_INCLUDE_DIR - the sqlite3 include directory
+#  SQLITE3_LIBRARY - Link this to use the sqlite3 library
+
+FIND_PATH(SQLITE3_INCLUDE_DIR
+  sqlite3.h
+  "$ENV{LIB_DIR}/include"
+  "$ENV{INCLUDE}"
+  /usr/local/include
+  /usr/include
+)
+
+FIND_LIBRARY(SQLITE3_LIBRARY NAMES sqlite3 PATHS "$ENV{LIB_DIR}/lib" "$ENV{LIB}" /usr/local/lib /usr/lib )
+
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(SQLite3 DEFAULT_MSG
+                                  SQLITE3_LIBRARY SQLITE3_INCLUDE_DIR)
+
+MARK_AS_ADVANCED(SQLITE3_LIBRARY SQLITE3_INCLUDE_DIR)
+
+IF (SQLITE3_FOUND)
+  MESSAGE(STATUS "Found sqlite3: ${SQLITE3_LIBRARY}")
+ELSE (SQLITE3_FOUND)
+  SET(SQLITE3_LIBRARY "")
+  SET(SQLITE3_INCLUDE_DIR "")
+  MESSAGE(STATUS "Could not find sqlite3")
+ENDIF (SQLITE3_FOUND)
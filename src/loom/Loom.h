@@ -0,0 +1,21 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef LOOM_LOOM_H_
+#define LOOM_LOOM_H_
+
+#include "loom/config/LoomConfig.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "util/json/Writer.h"
+
+namespace loom {
+
+// Optimize the line orderings of g in place. Returns the statistics to be
+// written to the output graph properties, empty if none were requested.
+util::json::Dict run(const config::Config* cfg,
+                     shared::rendergraph::RenderGraph* g);
+
+}  // namespace loom
+
+#endif  // LOOM_LOOM_H_
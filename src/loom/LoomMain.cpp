@@ -8,15 +8,14 @@
 #include <iostream>
 #include <set>
 #include <string>
+#include "loom/Loom.h"
 #include "loom/config/ConfigReader.cpp"
 #include "loom/config/LoomConfig.h"
-#include "loom/optim/CombOptimizer.h"
-#include "loom/optim/GreedyOptimizer.h"
-#include "loom/optim/ILPEdgeOrderOptimizer.h"
-#include "shared/rendergraph/Penalties.h"
+#include "shared/linegraph/BinGraphView.h"
+#include "shared/linegraph/ComponentWriter.h"
+#include "shared/linegraph/GeoJsonWriter.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "util/geo/PolyLine.h"
-#include "util/geo/output/GeoGraphJsonOutput.h"
 #include "util/log/Log.h"
 
 using namespace loom;
@@ -31,120 +30,86 @@ int main(int argc, char** argv) {
   config::ConfigReader cr;
   cr.read(&cfg, argc, argv);
 
+  // binary input files are mapped into memory instead of being read
+  shared::linegraph::BinGraphView view;
+  bool mapped = !cfg.fromDot && view.open(STDIN_FILENO);
+
+  if (cfg.stream && !cfg.fromDot) {
+    // each chunk of the input stream (a binary graph section or a GeoJSON
+    // feature collection) holds independent components, optimize and write
+    // them one by one as they arrive
+    shared::linegraph::ComponentWriter out(&std::cout, cfg.outputFormat);
+    util::json::Array sectionStats;
+
+    size_t sec = 0;
+
+    while (true) {
+      shared::rendergraph::RenderGraph g(5, 1, 5);
+
+      if (mapped) {
+        if (sec == view.getSections().size()) break;
+
+        // sections only holding graph properties are skipped without
+        // building a graph from them
+        if (view.getSections()[sec].header->numNds == 0) {
+          sec++;
+          continue;
+        }
+
+        // only the graph of the current section is held in memory
+        view.materialize(&g, sec++);
+      } else {
+        if (!g.readChunk(&std::cin)) break;
+
+        // chunks only holding graph properties
+        if (g.getNds().size() == 0) continue;
+      }
+
+      LOGTO(DEBUG, std::cerr) << "Optimizing section " << out.numWritten()
+                              << "...";
+      util::json::Dict jsonStats = loom::run(&cfg, &g);
+      if (cfg.writeStats) sectionStats.push_back(jsonStats);
+
+      out.write(g);
+    }
+
+    util::json::Dict props;
+    if (cfg.writeStats) props["section-statistics"] = sectionStats;
+    out.close(props);
+
+    return (0);
+  }
+
   LOGTO(DEBUG, std::cerr) << "Reading graph...";
   shared::rendergraph::RenderGraph g(5, 1, 5);
 
   if (cfg.fromDot) {
     g.readFromDot(&std::cin);
+  } else if (mapped) {
+    view.materialize(&g);
   } else {
     g.readFromJson(&std::cin);
   }
 
   LOGTO(DEBUG, std::cerr) << "Optimizing...";
 
-  double maxCrossPen =
-      g.maxDeg() * std::max(cfg.crossPenMultiSameSeg,
-                            std::max(cfg.crossPenMultiDiffSeg,
-                                     std::max(cfg.stationCrossWeightSameSeg,
-                                              cfg.stationCrossWeightDiffSeg)));
-  double maxSepPen = g.maxDeg() * std::max(cfg.separationPenWeight,
-                                           cfg.stationSeparationWeight);
-
-  // TODO move this into configuration, at least partially
-  shared::rendergraph::Penalties pens{maxCrossPen,
-                                      maxSepPen,
-                                      cfg.crossPenMultiSameSeg,
-                                      cfg.crossPenMultiDiffSeg,
-                                      cfg.separationPenWeight,
-                                      cfg.stationCrossWeightSameSeg,
-                                      cfg.stationCrossWeightDiffSeg,
-                                      cfg.stationSeparationWeight,
-                                      true,
-                                      true};
-  loom::optim::OptResStats stats;
-
-  if (cfg.optimMethod == "ilp-naive") {
-    optim::ILPOptimizer ilpOptim(&cfg, pens);
-    stats = ilpOptim.optimize(&g);
-  } else if (cfg.optimMethod == "ilp") {
-    optim::ILPEdgeOrderOptimizer ilpEoOptim(&cfg, pens);
-    stats = ilpEoOptim.optimize(&g);
-  } else if (cfg.optimMethod == "comb") {
-    optim::CombOptimizer ilpCombiOptim(&cfg, pens);
-    stats = ilpCombiOptim.optimize(&g);
-  } else if (cfg.optimMethod == "exhaust") {
-    optim::ExhaustiveOptimizer exhausOptim(&cfg, pens);
-    stats = exhausOptim.optimize(&g);
-  } else if (cfg.optimMethod == "hillc") {
-    optim::HillClimbOptimizer hillcOptim(&cfg, pens, false);
-    stats = hillcOptim.optimize(&g);
-  } else if (cfg.optimMethod == "hillc-random") {
-    optim::HillClimbOptimizer hillcOptim(&cfg, pens, true);
-    stats = hillcOptim.optimize(&g);
-  } else if (cfg.optimMethod == "anneal") {
-    optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, false);
-    stats = annealOptim.optimize(&g);
-  } else if (cfg.optimMethod == "anneal-random") {
-    optim::SimulatedAnnealingOptimizer annealOptim(&cfg, pens, true);
-    stats = annealOptim.optimize(&g);
-  } else if (cfg.optimMethod == "greedy") {
-    optim::GreedyOptimizer greedyOptim(&cfg, pens, false);
-    stats = greedyOptim.optimize(&g);
-  } else if (cfg.optimMethod == "greedy-lookahead") {
-    optim::GreedyOptimizer greedyOptim(&cfg, pens, true);
-    stats = greedyOptim.optimize(&g);
-  } else if (cfg.optimMethod == "null") {
-    optim::NullOptimizer nullOptim(&cfg, pens);
-    stats = nullOptim.optimize(&g);
-  } else {
-    LOG(ERROR) << "Unknown optimization method " << cfg.optimMethod
-               << std::endl;
-    exit(1);
-  }
+  util::json::Dict jsonStats = loom::run(&cfg, &g);
 
-  util::geo::output::GeoGraphJsonOutput out;
-
-  if (cfg.writeStats) {
-    util::json::Dict jsonStats = {
-        {"statistics",
-         util::json::Dict{
-             {"input_num_nodes", stats.numNodesOrig},
-             {"input_num_stations", stats.numStationsOrig},
-             {"input_num_edges", stats.numEdgesOrig},
-             {"input_max_number_lines", stats.maxLineCardOrig},
-             {"input_max_deg", stats.maxDegOrig},
-             {"input_num_lines", stats.numLinesOrig},
-             {"input_solution_space_size", stats.solutionSpaceSizeOrig},
-             {"input_num_comps", stats.numCompsOrig},
-             {"optgraph_num_nodes", stats.numNodes},
-             {"optgraph_num_stations", stats.numStations},
-             {"optgraph_num_edges", stats.numEdges},
-             {"optgraph_max_number_lines", stats.maxLineCard},
-             {"optgraph_solution_space_size", stats.solutionSpaceSize},
-             {"optgraph_nontrivial_comps", stats.nonTrivialComponents},
-             {"optgraph_nontrivial_comps_searchspace_one",
-              stats.numCompsSolSpaceOne},
-             {"optgraph_max_num_nodes_in_comps", stats.maxNumNodesPerComp},
-             {"optgraph_max_num_edges_in_comps", stats.maxNumEdgesPerComp},
-             {"optgraph_max_number_lines_in_comps", stats.maxCardPerComp},
-             {"optraph_max_solution_space_size_in_comps", stats.maxCompSolSpace},
-             {"runs", stats.runs},
-             {"max_num_cols_in_comp", stats.maxNumColsPerComp},
-             {"max_num_rows_in_comp", stats.maxNumRowsPerComp},
-             {"avg_solve_time", stats.avgSolveTime},
-             {"avg_score", stats.avgScore},
-             {"avg_num_same_seg_crossings", stats.avgSameSegCross},
-             {"avg_num_diff_seg_crossings", stats.avgDiffSegCross},
-             {"avg_num_crossings", stats.avgCross},
-             {"avg_num_separations", stats.avgSeps},
-             {"best_num_same_seg_crossings", stats.sameSegCrossings},
-             {"best_num_diff_seg_crossings", stats.diffSegCrossings},
-             {"best_num_separations", stats.separations},
-             {"line_graph_simplification_time", stats.simplificationTime},
-             {"best_score", stats.score}}}};
-    out.printLatLng(g, std::cout, jsonStats);
+  if (cfg.outputFormat == "bin") {
+    g.writeToBin(&std::cout, jsonStats);
   } else {
-    out.printLatLng(g, std::cout);
+    // in compact mode, lines are written once to the collection properties
+    // and referenced by index from the edges
+    shared::linegraph::LineDict lineDict;
+    if (cfg.outputFormat == "json-compact") {
+      g.addToLineDict(&lineDict);
+      jsonStats["lines"] = lineDict.toJson();
+    }
+
+    shared::linegraph::GeoJsonWriter out(&std::cout, jsonStats);
+    if (cfg.outputFormat == "json-compact") out.setLineDict(&lineDict);
+    out.printLatLng(g);
+    out.flush();
   }
 
   return (0);
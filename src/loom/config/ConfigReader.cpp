@@ -68,6 +68,10 @@ void ConfigReader::help(const char* bin) const {
             << "Print stats to stdout\n"
             << std::setw(41) << "  --write-stats"
             << "Write stats to output\n"
+            << std::setw(41) << "  --out-format arg (=json)"
+            << "Output format, one of json, json-compact, bin\n"
+            << std::setw(41) << "  --stream"
+            << "Optimize and write input component by component\n"
             << std::setw(41) << "  --ilp-solver arg (=gurobi)"
             << "Preferred ILP solver, either glpk, cbc, or gurobi.\n"
             << std::setw(41) << " "
@@ -107,6 +111,8 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       {"dbg-output-path", required_argument, 0, 14},
       {"output-optgraph", required_argument, 0, 15},
       {"write-stats", no_argument, 0, 16},
+      {"out-format", required_argument, 0, 17},
+      {"stream", no_argument, 0, 18},
       {0, 0, 0, 0}};
 
   int c;
@@ -169,6 +175,12 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 16:
         cfg->writeStats = true;
         break;
+      case 17:
+        cfg->outputFormat = optarg;
+        break;
+      case 18:
+        cfg->stream = true;
+        break;
       case 'D':
         cfg->fromDot = true;
         break;
@@ -187,4 +199,10 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
         break;
     }
   }
+
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "json-compact" &&
+      cfg->outputFormat != "bin") {
+    std::cerr << "Unknown output format " << cfg->outputFormat << std::endl;
+    exit(1);
+  }
 }
@@ -29,6 +29,9 @@ struct Config {
   bool untangleGraph = true;
   bool fromDot = false;
 
+  std::string outputFormat = "json";
+  bool stream = false;
+
   int ilpTimeLimit = -1;
   int ilpNumThreads = 0;
 
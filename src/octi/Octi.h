@@ -0,0 +1,41 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef OCTI_OCTI_H_
+#define OCTI_OCTI_H_
+
+#include <string>
+#include <vector>
+
+#include "octi/basegraph/BaseGraph.h"
+#include "octi/config/OctiConfig.h"
+#include "shared/linegraph/ComponentWriter.h"
+#include "shared/linegraph/LineGraph.h"
+#include "util/geo/Geo.h"
+#include "util/json/Writer.h"
+
+namespace octi {
+
+// Schematize each connected component of lg. The resulting graphs are
+// written to res, the base graphs they were drawn on are written to gridRes
+// if the print mode is "gridgraph". Returns the statistics to be written to
+// the output graph properties, empty if none were requested.
+util::json::Dict run(const config::Config* cfg,
+                     shared::linegraph::LineGraph* lg,
+                     std::vector<shared::linegraph::LineGraph*>* res,
+                     std::vector<basegraph::BaseGraph*>* gridRes);
+
+// as above, but each result graph is written to out as soon as its
+// component has been drawn, and is not kept in res afterwards
+util::json::Dict run(const config::Config* cfg,
+                     shared::linegraph::LineGraph* lg,
+                     std::vector<shared::linegraph::LineGraph*>* res,
+                     std::vector<basegraph::BaseGraph*>* gridRes,
+                     shared::linegraph::ComponentWriter* out);
+
+std::vector<util::geo::DPolygon> readObstacleFile(const std::string& p);
+
+}  // namespace octi
+
+#endif  // OCTI_OCTI_H_
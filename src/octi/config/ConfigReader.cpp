@@ -80,6 +80,10 @@ void ConfigReader::help(const char* bin) const {
             << " will fall back if not available.\n"
             << std::setw(39) << "  --write-stats"
             << "write stats to output graph\n"
+            << std::setw(39) << "  --out-format arg (=json)"
+            << "output format, one of json, json-compact, bin\n"
+            << std::setw(39) << "  --stream"
+            << "read and write input component by component\n"
             << std::setw(39) << "  -D [ --from-dot ]"
             << "input is in dot format\n"
             << std::setw(39) << "  --no-deg2-heur"
@@ -154,6 +158,8 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"skip-on-error", no_argument, 0, 25},
                          {"retry-on-error", no_argument, 0, 26},
                          {"abort-after", required_argument, 0, 'a'},
+                         {"out-format", required_argument, 0, 27},
+                         {"stream", no_argument, 0, 28},
                          {0, 0, 0, 0}};
 
   int c;
@@ -247,6 +253,12 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 26:
         cfg->retryOnError = true;
         break;
+      case 27:
+        cfg->outputFormat = optarg;
+        break;
+      case 28:
+        cfg->stream = true;
+        break;
       case 'g':
         cfg->gridSize = optarg;
         break;
@@ -272,6 +284,12 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     }
   }
 
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "json-compact" &&
+      cfg->outputFormat != "bin") {
+    LOG(ERROR) << "Unknown output format " << cfg->outputFormat;
+    exit(1);
+  }
+
   if (edgeOrderMethod == "num-lines") {
     cfg->orderMethod = OrderMethod::NUM_LINES;
   } else if (edgeOrderMethod == "length") {
@@ -28,6 +28,8 @@ struct Config {
   double borderRad = 45;
 
   std::string printMode = "linegraph";
+  std::string outputFormat = "json";
+  bool stream = false;
   std::string optMode = "heur";
   std::string ilpPath;
   bool fromDot = false;
@@ -0,0 +1,148 @@
+// Copyright 2016
+// University of Freiburg - Chair of Algorithms and Datastructures
+// Author: Patrick Brosi
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "loom/Loom.h"
+#include "octi/Octi.h"
+#include "pipeline/config/ConfigReader.h"
+#include "pipeline/config/PipelineConfig.h"
+#include "shared/linegraph/BinGraphView.h"
+#include "shared/linegraph/GeoJsonWriter.h"
+#include "shared/linegraph/LineDict.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "topo/Topo.h"
+#include "transitmap/TransitMap.h"
+#include "util/Misc.h"
+#include "util/log/Log.h"
+
+using shared::linegraph::BinGraphView;
+using shared::linegraph::LineGraph;
+using shared::rendergraph::RenderGraph;
+
+// _____________________________________________________________________________
+void writeGraph(const LineGraph& g, const std::string& format,
+                util::json::Dict props) {
+  if (format == "bin") {
+    g.writeToBin(&std::cout, props);
+  } else {
+    // in compact mode, lines are written once to the collection properties
+    // and referenced by index from the edges
+    shared::linegraph::LineDict lineDict;
+    if (format == "json-compact") {
+      g.addToLineDict(&lineDict);
+      props["lines"] = lineDict.toJson();
+    }
+
+    shared::linegraph::GeoJsonWriter out(&std::cout, props);
+    if (format == "json-compact") out.setLineDict(&lineDict);
+    out.printLatLng(g);
+    out.flush();
+  }
+}
+
+// _____________________________________________________________________________
+int main(int argc, char** argv) {
+  // disable output buffering for standard output
+  setbuf(stdout, NULL);
+
+  // initialize randomness
+  srand(time(NULL) + rand());
+
+  pipeline::config::Config cfg;
+
+  pipeline::config::ConfigReader cr;
+  cr.read(&cfg, argc, argv);
+
+  if (cfg.octiCfg.obstaclePath.size()) {
+    LOGTO(DEBUG, std::cerr) << "Reading obstacle file...";
+    cfg.octiCfg.obstacles = octi::readObstacleFile(cfg.octiCfg.obstaclePath);
+    LOGTO(DEBUG, std::cerr) << "Done. (" << cfg.octiCfg.obstacles.size()
+                            << " obst.)";
+  }
+
+  // only the first stage reads the input
+  const auto& first = cfg.stages.front();
+  bool fromDot = (first == "loom" && cfg.loomCfg.fromDot) ||
+                 (first == "octi" && cfg.octiCfg.fromDot) ||
+                 (first == "transitmap" && cfg.transitmapCfg.fromDot);
+
+  T_START(total);
+
+  LOGTO(DEBUG, std::cerr) << "Reading graph...";
+  T_START(read);
+  LineGraph g;
+  BinGraphView view;
+
+  if (fromDot)
+    g.readFromDot(&std::cin);
+  else if (view.open(STDIN_FILENO))
+    view.materialize(&g);
+  else
+    g.readFromJson(&std::cin);
+
+  LOGTO(INFO, std::cerr) << "Reading input took " << T_STOP(read) << " ms";
+
+  // the graph is handed over between the stages in memory, stages producing
+  // one graph per component have their results merged back into one graph
+  util::json::Dict props;
+  std::string outFormat;
+
+  for (const auto& stage : cfg.stages) {
+    LOGTO(DEBUG, std::cerr) << "Running stage " << stage << "...";
+    T_START(stage);
+
+    if (stage == "topo") {
+      std::vector<LineGraph> res;
+      props = topo::run(&cfg.topoCfg, &g, &res);
+
+      LineGraph next;
+      for (auto& comp : res) next.absorb(&comp);
+
+      // the input graph is deleted with next
+      std::swap(g, next);
+      outFormat = cfg.topoCfg.outputFormat;
+    } else if (stage == "loom") {
+      RenderGraph rg(std::move(g), 5, 1, 5);
+      props = loom::run(&cfg.loomCfg, &rg);
+      g = std::move(rg);
+      outFormat = cfg.loomCfg.outputFormat;
+    } else if (stage == "octi") {
+      std::vector<LineGraph*> res;
+      std::vector<octi::basegraph::BaseGraph*> gridRes;
+      props = octi::run(&cfg.octiCfg, &g, &res, &gridRes);
+
+      LineGraph next;
+      for (auto comp : res) {
+        next.absorb(comp);
+        delete comp;
+      }
+      for (auto gg : gridRes) delete gg;
+
+      // the input graph is deleted with next
+      std::swap(g, next);
+      outFormat = cfg.octiCfg.outputFormat;
+    } else {
+      transitmapper::run(&cfg.transitmapCfg, &g, &std::cout);
+      outFormat = "";
+    }
+
+    LOGTO(INFO, std::cerr) << "Stage " << stage << " took " << T_STOP(stage)
+                           << " ms";
+  }
+
+  // the last stage did not render the graph, output it
+  if (!outFormat.empty()) writeGraph(g, outFormat, props);
+
+  LOGTO(INFO, std::cerr) << "Pipeline took " << T_STOP(total) << " ms";
+
+  return (0);
+}
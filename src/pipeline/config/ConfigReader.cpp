@@ -0,0 +1,192 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <getopt.h>
+
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "loom/config/ConfigReader.h"
+#include "octi/config/ConfigReader.h"
+#include "pipeline/_config.h"
+#include "pipeline/config/ConfigReader.h"
+#include "topo/config/ConfigReader.h"
+#include "transitmap/config/ConfigReader.h"
+#include "util/String.h"
+#include "util/log/Log.h"
+
+using pipeline::config::ConfigReader;
+
+using std::string;
+using std::vector;
+
+static const char* YEAR = &__DATE__[7];
+static const char* COPY =
+    "University of Freiburg - Chair of Algorithms and Data Structures";
+static const char* AUTHORS = "Patrick Brosi <brosi@informatik.uni-freiburg.de>";
+
+static const char* STAGES[] = {"topo", "loom", "octi", "transitmap"};
+
+// _____________________________________________________________________________
+static vector<char*> toArgv(vector<string>* args) {
+  vector<char*> ret;
+  for (auto& a : *args) ret.push_back(const_cast<char*>(a.c_str()));
+  ret.push_back(0);
+  return ret;
+}
+
+// _____________________________________________________________________________
+ConfigReader::ConfigReader() {}
+
+// _____________________________________________________________________________
+void ConfigReader::help(const char* bin) const {
+  std::cout << std::setfill(' ') << std::left << "loom-pipeline (part of LOOM) "
+            << VERSION_FULL << "\n(built " << __DATE__ << " " << __TIME__ << ")"
+            << "\n\n(C) 2017-" << YEAR << " " << COPY << "\n"
+            << "Authors: " << AUTHORS << "\n\n"
+            << "Usage: " << bin << " < linegraph.json\n\n"
+            << "Runs a sequence of LOOM stages in a single process, handing\n"
+            << "over the graph in memory. Options of a stage are given with\n"
+            << "the stage name as prefix, e.g. --topo-max-aggr-dist 30,\n"
+            << "--loom-m ilp or --transitmap-help. The output options of the\n"
+            << "last stage determine the output.\n\n"
+            << "Allowed options:\n\n"
+            << "General:\n"
+            << std::setw(45) << "  -v [ --version ]"
+            << "print version\n"
+            << std::setw(45) << "  -h [ --help ]"
+            << "show this help message\n"
+            << std::setw(45) << "  --stages arg (=topo,loom,octi,transitmap)"
+            << "comma separated stages to run, transitmap\n"
+            << std::setw(45) << " "
+            << " may only be the last stage\n";
+}
+
+// _____________________________________________________________________________
+bool ConfigReader::isStage(const std::string& stage) {
+  for (auto s : STAGES) {
+    if (stage == s) return true;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+void ConfigReader::read(Config* cfg, int argc, char** argv) const {
+  // distribute the arguments to the stages, option arguments belong to the
+  // preceding option
+  vector<string> ownArgs{argv[0]};
+  std::map<string, vector<string>> stageArgs;
+  for (auto s : STAGES) stageArgs[s] = {s};
+
+  vector<string>* cur = &ownArgs;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.size() > 2 && arg[0] == '-' && arg[1] == '-') {
+      cur = &ownArgs;
+      size_t dash = arg.find('-', 2);
+      if (dash != string::npos && isStage(arg.substr(2, dash - 2))) {
+        cur = &stageArgs[arg.substr(2, dash - 2)];
+        string opt = arg.substr(dash + 1);
+        // single character options are passed in their short form
+        arg = (opt.size() == 1 ? "-" : "--") + opt;
+      }
+    } else if (arg.size() > 1 && arg[0] == '-' && isalpha(arg[1])) {
+      cur = &ownArgs;
+    }
+    cur->push_back(arg);
+  }
+
+  struct option ops[] = {{"version", no_argument, 0, 'v'},
+                         {"help", no_argument, 0, 'h'},
+                         {"stages", required_argument, 0, 1},
+                         {0, 0, 0, 0}};
+
+  auto ownArgv = toArgv(&ownArgs);
+
+  int c;
+  optind = 0;
+  while ((c = getopt_long(ownArgv.size() - 1, ownArgv.data(), ":hv", ops, 0)) !=
+         -1) {
+    switch (c) {
+      case 'h':
+        help(argv[0]);
+        exit(0);
+      case 'v':
+        std::cout << "loom-pipeline - (LOOM " << VERSION_FULL << ")"
+                  << std::endl;
+        exit(0);
+      case 1:
+        cfg->stages = util::split(optarg, ',');
+        break;
+      case ':':
+        std::cerr << ownArgv[optind - 1];
+        std::cerr << " requires an argument" << std::endl;
+        exit(1);
+      case '?':
+        std::cerr << ownArgv[optind - 1];
+        std::cerr << " option unknown" << std::endl;
+        exit(1);
+        break;
+      default:
+        std::cerr << "Error while parsing arguments" << std::endl;
+        exit(1);
+        break;
+    }
+  }
+
+  if (cfg->stages.empty()) {
+    LOG(ERROR) << "No stages given";
+    exit(1);
+  }
+
+  for (size_t i = 0; i < cfg->stages.size(); i++) {
+    if (!isStage(cfg->stages[i])) {
+      LOG(ERROR) << "Unknown stage " << cfg->stages[i];
+      exit(1);
+    }
+    if (cfg->stages[i] == "transitmap" && i != cfg->stages.size() - 1) {
+      LOG(ERROR) << "transitmap may only be the last stage";
+      exit(1);
+    }
+  }
+
+  for (auto s : STAGES) {
+    string stage = s;
+    bool used = false;
+    for (const auto& st : cfg->stages) used |= st == stage;
+
+    if (!used) {
+      if (stageArgs[stage].size() > 1) {
+        LOG(ERROR) << "Options given for stage " << stage
+                   << ", which is not part of the pipeline";
+        exit(1);
+      }
+      continue;
+    }
+
+    // each stage reader also applies its defaults, so run it even without
+    // arguments
+    auto stageArgv = toArgv(&stageArgs[stage]);
+    int stageArgc = stageArgv.size() - 1;
+    optind = 0;
+
+    if (stage == "topo") {
+      topo::config::ConfigReader().read(&cfg->topoCfg, stageArgc,
+                                        stageArgv.data());
+    } else if (stage == "loom") {
+      loom::config::ConfigReader().read(&cfg->loomCfg, stageArgc,
+                                        stageArgv.data());
+    } else if (stage == "octi") {
+      octi::config::ConfigReader().read(&cfg->octiCfg, stageArgc,
+                                        stageArgv.data());
+    } else {
+      transitmapper::config::ConfigReader().read(&cfg->transitmapCfg,
+                                                 stageArgc, stageArgv.data());
+    }
+  }
+}
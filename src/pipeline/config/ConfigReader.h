@@ -0,0 +1,27 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef PIPELINE_CONFIG_CONFIGREADER_H_
+#define PIPELINE_CONFIG_CONFIGREADER_H_
+
+#include <string>
+#include <vector>
+
+#include "pipeline/config/PipelineConfig.h"
+
+namespace pipeline {
+namespace config {
+
+class ConfigReader {
+ public:
+  ConfigReader();
+  void read(Config* targetConfig, int argc, char** argv) const;
+
+ private:
+  void help(const char* bin) const;
+  static bool isStage(const std::string& stage);
+};
+}  // namespace config
+}  // namespace pipeline
+#endif  // PIPELINE_CONFIG_CONFIGREADER_H_
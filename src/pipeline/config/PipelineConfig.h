@@ -0,0 +1,31 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef PIPELINE_CONFIG_PIPELINECONFIG_H_
+#define PIPELINE_CONFIG_PIPELINECONFIG_H_
+
+#include <string>
+#include <vector>
+
+#include "loom/config/LoomConfig.h"
+#include "octi/config/OctiConfig.h"
+#include "topo/config/TopoConfig.h"
+#include "transitmap/config/TransitMapConfig.h"
+
+namespace pipeline {
+namespace config {
+
+struct Config {
+  std::vector<std::string> stages{"topo", "loom", "octi", "transitmap"};
+
+  topo::config::TopoConfig topoCfg;
+  loom::config::Config loomCfg;
+  octi::config::Config octiCfg;
+  transitmapper::config::Config transitmapCfg;
+};
+
+}  // namespace config
+}  // namespace pipeline
+
+#endif  // PIPELINE_CONFIG_PIPELINECONFIG_H_
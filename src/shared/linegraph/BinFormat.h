@@ -0,0 +1,379 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_BINFORMAT_H_
+#define SHARED_LINEGRAPH_BINFORMAT_H_
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Binary line graph interchange format.
+//
+// A stream consists of one or more graph sections. Each section starts with
+// a fixed-size header, followed by the tables below in this order, each of
+// them padded to a multiple of 8 bytes:
+//
+//   uint64_t strOffs[numStrs + 1]   offsets into the string data
+//   LineRec lines[numLines]
+//   StyleRec styles[numStyles]
+//   StopRec stops[numStops]
+//   NdRec nds[numNds]
+//   EdgRec edgs[numEdgs]
+//   OccRec occs[numOccs]            line occurrences, in edge line order
+//   ExcRec excs[numExcs]            connection exceptions
+//   uint32_t notServed[numNotServed]
+//   char strData[strBytes]
+//   uint8_t geoms[geomBytes]        edge geometries, see below
+//
+// All integers are written in host byte order, the header carries a byte
+// order mark to reject streams written on a machine of other endianness.
+// Node positions are stored as doubles. Edge geometries are stored as deltas
+// against the previous point, the first point being a delta against (0, 0).
+// If all coordinates of an edge are exactly representable as fixed point
+// values with a resolution of 1 / COORD_RES, the deltas are zigzag varints
+// of these fixed point values. Otherwise, the edge is flagged with
+// EDG_RAW_GEOM and the deltas are varints of the XOR of the bit patterns of
+// the doubles. Both encodings are lossless.
+
+namespace shared {
+namespace linegraph {
+namespace bin {
+
+const char MAGIC[4] = {'L', 'G', 'B', 'F'};
+const uint32_t VERSION = 2;
+const uint32_t BOM = 0x01020304;
+const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+const double COORD_RES = 1000.0;
+
+const uint32_t EDG_DONT_CONTRACT = 1;
+const uint32_t EDG_RAW_GEOM = 2;
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t bom;
+  uint32_t props;  // string containing the serialized graph properties
+  uint64_t numStrs, strBytes, numLines, numStyles, numStops, numNds, numEdgs,
+      numOccs, numExcs, numNotServed, geomBytes;
+};
+
+struct LineRec {
+  uint32_t id, label, color;
+};
+
+struct StyleRec {
+  uint32_t css, outlineCss;
+};
+
+struct StopRec {
+  uint32_t id, name;
+  double x, y;
+};
+
+struct NdRec {
+  double x, y;
+  uint32_t comp;
+  uint32_t firstStop, numStops;
+  uint32_t firstNotServed, numNotServed;
+  uint32_t firstExc, numExcs;
+  uint32_t pad;
+};
+
+struct EdgRec {
+  uint32_t from, to;
+  uint32_t comp;
+  uint32_t flags;
+  uint64_t geomOff;
+  uint32_t numPts;
+  uint32_t firstOcc, numOccs;
+  uint32_t pad;
+};
+
+struct OccRec {
+  uint32_t line;
+  uint32_t dir;  // node index, or NONE
+  uint32_t style;  // style index, or NONE
+};
+
+struct ExcRec {
+  uint32_t line, edgA, edgB;
+};
+
+static_assert(sizeof(Header) == 104, "unexpected bin header size");
+static_assert(sizeof(NdRec) == 48, "unexpected bin node record size");
+static_assert(sizeof(EdgRec) == 40, "unexpected bin edge record size");
+
+// _____________________________________________________________________________
+inline size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+// _____________________________________________________________________________
+inline bool isBin(std::istream* s) {
+  return s->peek() == static_cast<unsigned char>(MAGIC[0]);
+}
+
+// _____________________________________________________________________________
+inline bool validHeader(const Header& h) {
+  if (memcmp(h.magic, MAGIC, 4) != 0 || h.version != VERSION || h.bom != BOM)
+    return false;
+
+  // table counts large enough to overflow sectionSize() are never valid
+  const uint64_t MAX_CNT = 1ull << 40;
+  return h.numStrs < MAX_CNT && h.strBytes < MAX_CNT && h.numLines < MAX_CNT &&
+         h.numStyles < MAX_CNT && h.numStops < MAX_CNT && h.numNds < MAX_CNT &&
+         h.numEdgs < MAX_CNT && h.numOccs < MAX_CNT && h.numExcs < MAX_CNT &&
+         h.numNotServed < MAX_CNT && h.geomBytes < MAX_CNT;
+}
+
+// _____________________________________________________________________________
+inline int64_t toFixed(double c) {
+  return static_cast<int64_t>(c * COORD_RES + (c < 0 ? -0.5 : 0.5));
+}
+
+// _____________________________________________________________________________
+inline double fromFixed(int64_t c) {
+  return static_cast<double>(c) / COORD_RES;
+}
+
+// _____________________________________________________________________________
+inline uint64_t toBits(double c) {
+  uint64_t ret;
+  memcpy(&ret, &c, sizeof(ret));
+  return ret;
+}
+
+// _____________________________________________________________________________
+inline double fromBits(uint64_t c) {
+  double ret;
+  memcpy(&ret, &c, sizeof(ret));
+  return ret;
+}
+
+// _____________________________________________________________________________
+inline bool isFixed(double c) {
+  // true if the fixed point value of c converts back to exactly c
+  if (!(c > -1e12 && c < 1e12)) return false;
+  return toBits(fromFixed(toFixed(c))) == toBits(c);
+}
+
+// _____________________________________________________________________________
+inline void writeVarUInt(uint64_t u, std::vector<uint8_t>* out) {
+  while (u >= 0x80) {
+    out->push_back(static_cast<uint8_t>(u | 0x80));
+    u >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(u));
+}
+
+// _____________________________________________________________________________
+inline uint64_t readVarUInt(const uint8_t** p) {
+  uint64_t u = 0;
+  size_t shift = 0;
+  while (**p & 0x80) {
+    u |= static_cast<uint64_t>(**p & 0x7F) << shift;
+    shift += 7;
+    (*p)++;
+  }
+  u |= static_cast<uint64_t>(**p) << shift;
+  (*p)++;
+  return u;
+}
+
+// _____________________________________________________________________________
+inline void writeVarInt(int64_t v, std::vector<uint8_t>* out) {
+  // zigzag
+  writeVarUInt((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63),
+               out);
+}
+
+// _____________________________________________________________________________
+inline int64_t readVarInt(const uint8_t** p) {
+  uint64_t u = readVarUInt(p);
+  return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+// _____________________________________________________________________________
+template <typename T>
+inline void writeTbl(std::ostream* s, const std::vector<T>& tbl) {
+  static const char zeros[8] = {0};
+  size_t bytes = tbl.size() * sizeof(T);
+  if (bytes) s->write(reinterpret_cast<const char*>(tbl.data()), bytes);
+  s->write(zeros, padded(bytes) - bytes);
+}
+
+// Pointers into the tables of a single graph section held in memory.
+struct Section {
+  const Header* header;
+  const uint64_t* strOffs;
+  const LineRec* lines;
+  const StyleRec* styles;
+  const StopRec* stops;
+  const NdRec* nds;
+  const EdgRec* edgs;
+  const OccRec* occs;
+  const ExcRec* excs;
+  const uint32_t* notServed;
+  const char* strData;
+  const uint8_t* geoms;
+
+  std::string str(uint32_t i) const {
+    return std::string(strData + strOffs[i], strOffs[i + 1] - strOffs[i]);
+  }
+};
+
+// _____________________________________________________________________________
+inline size_t sectionSize(const Header& h) {
+  return sizeof(Header) + padded((h.numStrs + 1) * sizeof(uint64_t)) +
+         padded(h.numLines * sizeof(LineRec)) +
+         padded(h.numStyles * sizeof(StyleRec)) +
+         padded(h.numStops * sizeof(StopRec)) +
+         padded(h.numNds * sizeof(NdRec)) +
+         padded(h.numEdgs * sizeof(EdgRec)) +
+         padded(h.numOccs * sizeof(OccRec)) +
+         padded(h.numExcs * sizeof(ExcRec)) +
+         padded(h.numNotServed * sizeof(uint32_t)) + padded(h.strBytes) +
+         padded(h.geomBytes);
+}
+
+// _____________________________________________________________________________
+inline Section mapSection(const char* data) {
+  // data must be 8-byte aligned and hold sectionSize() bytes
+  Section sec;
+  sec.header = reinterpret_cast<const Header*>(data);
+  const Header& h = *sec.header;
+  const char* p = data + sizeof(Header);
+
+  sec.strOffs = reinterpret_cast<const uint64_t*>(p);
+  p += padded((h.numStrs + 1) * sizeof(uint64_t));
+  sec.lines = reinterpret_cast<const LineRec*>(p);
+  p += padded(h.numLines * sizeof(LineRec));
+  sec.styles = reinterpret_cast<const StyleRec*>(p);
+  p += padded(h.numStyles * sizeof(StyleRec));
+  sec.stops = reinterpret_cast<const StopRec*>(p);
+  p += padded(h.numStops * sizeof(StopRec));
+  sec.nds = reinterpret_cast<const NdRec*>(p);
+  p += padded(h.numNds * sizeof(NdRec));
+  sec.edgs = reinterpret_cast<const EdgRec*>(p);
+  p += padded(h.numEdgs * sizeof(EdgRec));
+  sec.occs = reinterpret_cast<const OccRec*>(p);
+  p += padded(h.numOccs * sizeof(OccRec));
+  sec.excs = reinterpret_cast<const ExcRec*>(p);
+  p += padded(h.numExcs * sizeof(ExcRec));
+  sec.notServed = reinterpret_cast<const uint32_t*>(p);
+  p += padded(h.numNotServed * sizeof(uint32_t));
+  sec.strData = p;
+  p += padded(h.strBytes);
+  sec.geoms = reinterpret_cast<const uint8_t*>(p);
+
+  return sec;
+}
+
+// _____________________________________________________________________________
+inline bool skipVarInt(const uint8_t** p, const uint8_t* end) {
+  // a 64 bit varint takes at most 10 bytes
+  for (size_t i = 0; i < 10 && *p < end; i++) {
+    if (!(*(*p)++ & 0x80)) return true;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+inline void corrupt(const char* what) {
+  throw std::runtime_error(
+      std::string("Corrupt binary graph section, invalid ") + what + ".");
+}
+
+// _____________________________________________________________________________
+inline void checkIdx(uint64_t i, uint64_t n, const char* what) {
+  if (i >= n) corrupt(what);
+}
+
+// _____________________________________________________________________________
+inline void checkRange(uint64_t first, uint64_t num, uint64_t n,
+                       const char* what) {
+  if (first > n || num > n - first) corrupt(what);
+}
+
+// _____________________________________________________________________________
+inline void checkSection(const Section& sec) {
+  // check all indices of a mapped section against the header counts, so that
+  // a corrupt section is rejected before any table is dereferenced with them
+  const Header& h = *sec.header;
+
+  if (sec.strOffs[0] != 0) corrupt("string offset");
+  for (size_t i = 0; i < h.numStrs; i++) {
+    if (sec.strOffs[i] > sec.strOffs[i + 1]) corrupt("string offset");
+  }
+  if (sec.strOffs[h.numStrs] > h.strBytes) corrupt("string offset");
+
+  checkIdx(h.props, h.numStrs, "string index");
+
+  for (size_t i = 0; i < h.numLines; i++) {
+    checkIdx(sec.lines[i].id, h.numStrs, "string index");
+    checkIdx(sec.lines[i].label, h.numStrs, "string index");
+    checkIdx(sec.lines[i].color, h.numStrs, "string index");
+  }
+
+  for (size_t i = 0; i < h.numStyles; i++) {
+    checkIdx(sec.styles[i].css, h.numStrs, "string index");
+    checkIdx(sec.styles[i].outlineCss, h.numStrs, "string index");
+  }
+
+  for (size_t i = 0; i < h.numStops; i++) {
+    checkIdx(sec.stops[i].id, h.numStrs, "string index");
+    checkIdx(sec.stops[i].name, h.numStrs, "string index");
+  }
+
+  for (size_t i = 0; i < h.numNds; i++) {
+    const auto& rec = sec.nds[i];
+    checkRange(rec.firstStop, rec.numStops, h.numStops, "stop range");
+    checkRange(rec.firstNotServed, rec.numNotServed, h.numNotServed,
+               "not served line range");
+    checkRange(rec.firstExc, rec.numExcs, h.numExcs, "exception range");
+  }
+
+  for (size_t i = 0; i < h.numNotServed; i++) {
+    checkIdx(sec.notServed[i], h.numLines, "line index");
+  }
+
+  for (size_t i = 0; i < h.numExcs; i++) {
+    checkIdx(sec.excs[i].line, h.numLines, "line index");
+    checkIdx(sec.excs[i].edgA, h.numEdgs, "edge index");
+    checkIdx(sec.excs[i].edgB, h.numEdgs, "edge index");
+  }
+
+  for (size_t i = 0; i < h.numOccs; i++) {
+    checkIdx(sec.occs[i].line, h.numLines, "line index");
+    if (sec.occs[i].dir != NONE)
+      checkIdx(sec.occs[i].dir, h.numNds, "node index");
+    if (sec.occs[i].style != NONE)
+      checkIdx(sec.occs[i].style, h.numStyles, "style index");
+  }
+
+  const uint8_t* geomEnd = sec.geoms + h.geomBytes;
+
+  for (size_t i = 0; i < h.numEdgs; i++) {
+    const auto& rec = sec.edgs[i];
+    checkIdx(rec.from, h.numNds, "node index");
+    checkIdx(rec.to, h.numNds, "node index");
+    checkRange(rec.firstOcc, rec.numOccs, h.numOccs, "line occurrence range");
+    checkRange(rec.geomOff, 0, h.geomBytes, "geometry offset");
+
+    const uint8_t* p = sec.geoms + rec.geomOff;
+    for (size_t j = 0; j < 2 * static_cast<size_t>(rec.numPts); j++) {
+      if (!skipVarInt(&p, geomEnd)) corrupt("geometry");
+    }
+  }
+}
+
+}  // namespace bin
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_BINFORMAT_H_
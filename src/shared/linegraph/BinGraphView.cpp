@@ -0,0 +1,221 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include "shared/linegraph/BinGraphView.h"
+
+using shared::linegraph::BinGraphView;
+using shared::linegraph::LineGraph;
+
+namespace bin = shared::linegraph::bin;
+
+// _____________________________________________________________________________
+static void checkAccess(uint64_t i, uint64_t n, const char* what) {
+  if (i >= n) throw std::out_of_range(std::string(what) + " out of range.");
+}
+
+// _____________________________________________________________________________
+BinGraphView::BinGraphView() : _map(0), _mapSize(0), _data(0), _size(0) {}
+
+// _____________________________________________________________________________
+BinGraphView::~BinGraphView() { close(); }
+
+// _____________________________________________________________________________
+void BinGraphView::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Could not open " + path);
+
+  bool ok = false;
+  try {
+    ok = open(fd);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  if (!ok) throw std::runtime_error(path + " is not a binary line graph.");
+}
+
+// _____________________________________________________________________________
+bool BinGraphView::open(int fd) {
+  close();
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+  // the graph starts at the current offset, not necessarily at the beginning
+  // of the file
+  off_t off = lseek(fd, 0, SEEK_CUR);
+  if (off < 0 || off > st.st_size) return false;
+
+  size_t size = st.st_size - off;
+  if (size < sizeof(bin::Header)) return false;
+
+  // check the magic bytes without moving the file offset
+  char magic[4];
+  if (pread(fd, magic, 4, off) != 4 || memcmp(magic, bin::MAGIC, 4) != 0)
+    return false;
+
+  // mmap() offsets must be a multiple of the page size
+  off_t pageOff = off - off % sysconf(_SC_PAGESIZE);
+  size_t mapSize = size + (off - pageOff);
+
+  void* map = mmap(0, mapSize, PROT_READ, MAP_PRIVATE, fd, pageOff);
+  if (map == MAP_FAILED) return false;
+
+  const char* data = static_cast<const char*>(map) + (off - pageOff);
+
+  // the tables are accessed in place and must be 8-byte aligned, leave
+  // unaligned input to the stream reader
+  if (reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+    munmap(map, mapSize);
+    return false;
+  }
+
+  _map = map;
+  _mapSize = mapSize;
+  _data = data;
+  _size = size;
+
+  index();
+
+  // the graph has been consumed from the descriptor
+  lseek(fd, 0, SEEK_END);
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void BinGraphView::close() {
+  if (_map) munmap(_map, _mapSize);
+  _map = 0;
+  _mapSize = 0;
+  _data = 0;
+  _size = 0;
+  _secs.clear();
+}
+
+// _____________________________________________________________________________
+void BinGraphView::index() {
+  // all table indices and offsets are checked once here, so the accessors
+  // below and materialize() can rely on them
+  size_t off = 0;
+  while (off < _size) {
+    if (_size - off < sizeof(bin::Header))
+      throw std::runtime_error("Truncated binary graph header.");
+
+    const bin::Header* h = reinterpret_cast<const bin::Header*>(_data + off);
+    if (!bin::validHeader(*h))
+      throw std::runtime_error("Invalid or unsupported binary graph header.");
+
+    size_t size = bin::sectionSize(*h);
+    if (size > _size - off)
+      throw std::runtime_error("Unexpected end of binary graph file.");
+
+    _secs.push_back(bin::mapSection(_data + off));
+    bin::checkSection(_secs.back());
+    off += size;
+  }
+}
+
+// _____________________________________________________________________________
+size_t BinGraphView::numNds() const {
+  size_t ret = 0;
+  for (const auto& sec : _secs) ret += sec.header->numNds;
+  return ret;
+}
+
+// _____________________________________________________________________________
+size_t BinGraphView::numEdgs() const {
+  size_t ret = 0;
+  for (const auto& sec : _secs) ret += sec.header->numEdgs;
+  return ret;
+}
+
+// _____________________________________________________________________________
+const bin::NdRec& BinGraphView::nd(const bin::Section& sec, size_t i) {
+  checkAccess(i, sec.header->numNds, "Node index");
+  return sec.nds[i];
+}
+
+// _____________________________________________________________________________
+const bin::EdgRec& BinGraphView::edg(const bin::Section& sec, size_t i) {
+  checkAccess(i, sec.header->numEdgs, "Edge index");
+  return sec.edgs[i];
+}
+
+// _____________________________________________________________________________
+const bin::OccRec* BinGraphView::lineOccsBegin(const bin::Section& sec,
+                                               size_t e) {
+  checkAccess(e, sec.header->numEdgs, "Edge index");
+  return sec.occs + sec.edgs[e].firstOcc;
+}
+
+// _____________________________________________________________________________
+const bin::OccRec* BinGraphView::lineOccsEnd(const bin::Section& sec,
+                                             size_t e) {
+  checkAccess(e, sec.header->numEdgs, "Edge index");
+  return sec.occs + sec.edgs[e].firstOcc + sec.edgs[e].numOccs;
+}
+
+// _____________________________________________________________________________
+std::string BinGraphView::lineId(const bin::Section& sec, uint32_t l) {
+  checkAccess(l, sec.header->numLines, "Line index");
+  return sec.str(sec.lines[l].id);
+}
+
+// _____________________________________________________________________________
+std::string BinGraphView::lineLabel(const bin::Section& sec, uint32_t l) {
+  checkAccess(l, sec.header->numLines, "Line index");
+  return sec.str(sec.lines[l].label);
+}
+
+// _____________________________________________________________________________
+std::string BinGraphView::lineColor(const bin::Section& sec, uint32_t l) {
+  checkAccess(l, sec.header->numLines, "Line index");
+  return sec.str(sec.lines[l].color);
+}
+
+// _____________________________________________________________________________
+util::geo::PolyLine<double> BinGraphView::edgGeom(const bin::Section& sec,
+                                                  size_t e) {
+  checkAccess(e, sec.header->numEdgs, "Edge index");
+  util::geo::PolyLine<double> pl;
+  const uint8_t* p = sec.geoms + sec.edgs[e].geomOff;
+
+  if (sec.edgs[e].flags & bin::EDG_RAW_GEOM) {
+    uint64_t x = 0, y = 0;
+    for (size_t j = 0; j < sec.edgs[e].numPts; j++) {
+      x ^= bin::readVarUInt(&p);
+      y ^= bin::readVarUInt(&p);
+      pl << util::geo::DPoint(bin::fromBits(x), bin::fromBits(y));
+    }
+  } else {
+    int64_t x = 0, y = 0;
+    for (size_t j = 0; j < sec.edgs[e].numPts; j++) {
+      x += bin::readVarInt(&p);
+      y += bin::readVarInt(&p);
+      pl << util::geo::DPoint(bin::fromFixed(x), bin::fromFixed(y));
+    }
+  }
+
+  return pl;
+}
+
+// _____________________________________________________________________________
+void BinGraphView::materialize(LineGraph* g) const { g->readFromBin(_secs); }
+
+// _____________________________________________________________________________
+void BinGraphView::materialize(LineGraph* g, size_t sec) const {
+  checkAccess(sec, _secs.size(), "Section index");
+  g->readFromBin({_secs[sec]});
+}
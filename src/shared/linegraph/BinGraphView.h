@@ -0,0 +1,79 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_BINGRAPHVIEW_H_
+#define SHARED_LINEGRAPH_BINGRAPHVIEW_H_
+
+#include <string>
+#include <vector>
+
+#include "shared/linegraph/BinFormat.h"
+#include "shared/linegraph/LineGraph.h"
+#include "util/geo/PolyLine.h"
+
+namespace shared {
+namespace linegraph {
+
+// Read-only view on a binary line graph file which is mapped into memory.
+// Nodes, edges and lines are accessed directly on the mapped tables, a
+// mutable LineGraph is only built on materialize().
+class BinGraphView {
+ public:
+  BinGraphView();
+  ~BinGraphView();
+
+  BinGraphView(const BinGraphView&) = delete;
+  BinGraphView& operator=(const BinGraphView&) = delete;
+
+  // map the binary graph file at the given path, throws on failure
+  void open(const std::string& path);
+
+  // map the binary graph behind a file descriptor, starting at its current
+  // offset. On success, the descriptor is positioned at the end of the file.
+  // Returns false without touching the descriptor if it is not a regular file
+  // holding a binary graph (for example a pipe, or GeoJSON input).
+  bool open(int fd);
+
+  void close();
+
+  const std::vector<bin::Section>& getSections() const { return _secs; }
+
+  size_t numNds() const;
+  size_t numEdgs() const;
+
+  // accessors on the mapped tables of a single section, throw if the index is
+  // out of range
+  static const bin::NdRec& nd(const bin::Section& sec, size_t i);
+  static const bin::EdgRec& edg(const bin::Section& sec, size_t i);
+  static const bin::OccRec* lineOccsBegin(const bin::Section& sec, size_t e);
+  static const bin::OccRec* lineOccsEnd(const bin::Section& sec, size_t e);
+  static std::string lineId(const bin::Section& sec, uint32_t l);
+  static std::string lineLabel(const bin::Section& sec, uint32_t l);
+  static std::string lineColor(const bin::Section& sec, uint32_t l);
+  static util::geo::PolyLine<double> edgGeom(const bin::Section& sec,
+                                             size_t e);
+
+  // build a mutable line graph from the mapped data
+  void materialize(LineGraph* g) const;
+
+  // build a mutable line graph from a single mapped section
+  void materialize(LineGraph* g, size_t sec) const;
+
+ private:
+  // the mapping starts at a page boundary, _data at the graph itself
+  void* _map;
+  size_t _mapSize;
+
+  const char* _data;
+  size_t _size;
+
+  std::vector<bin::Section> _secs;
+
+  void index();
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_BINGRAPHVIEW_H_
@@ -0,0 +1,53 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include "shared/linegraph/ComponentWriter.h"
+#include "shared/linegraph/GeoJsonWriter.h"
+#include "shared/linegraph/LineDict.h"
+#include "shared/linegraph/LineGraph.h"
+
+using shared::linegraph::ComponentWriter;
+using shared::linegraph::LineGraph;
+
+// _____________________________________________________________________________
+ComponentWriter::ComponentWriter(std::ostream* out, const std::string& format)
+    : _out(out), _format(format), _numWritten(0) {}
+
+// _____________________________________________________________________________
+void ComponentWriter::write(const LineGraph& g) {
+  util::json::Dict props;
+  props["component"] = _numWritten;
+
+  if (_format == "bin") {
+    g.writeToBin(_out, props);
+    _out->flush();
+  } else {
+    // the line dictionary only covers the lines of this component
+    LineDict lineDict;
+    if (_format == "json-compact") {
+      g.addToLineDict(&lineDict);
+      props["lines"] = lineDict.toJson();
+    }
+
+    GeoJsonWriter json(_out, props);
+    if (_format == "json-compact") json.setLineDict(&lineDict);
+    json.setComponent(_numWritten);
+    json.printLatLng(g);
+    json.flush();
+  }
+
+  _numWritten++;
+}
+
+// _____________________________________________________________________________
+void ComponentWriter::close(util::json::Dict props) {
+  if (!props.size()) return;
+
+  if (_format == "bin") {
+    LineGraph().writeToBin(_out, props);
+    _out->flush();
+  } else {
+    GeoJsonWriter(_out, props).flush();
+  }
+}
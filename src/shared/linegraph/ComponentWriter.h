@@ -0,0 +1,57 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_COMPONENTWRITER_H_
+#define SHARED_LINEGRAPH_COMPONENTWRITER_H_
+
+#include <ostream>
+#include <string>
+
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+class LineGraph;
+
+// Streaming output of graph components. Each component is written to the
+// output stream as a self-contained chunk as soon as it is passed to write(),
+// so the next tool in a pipe can start reading while later components are
+// still being processed.
+//
+// In the binary format, each component is written as its own graph section,
+// the graph properties follow in a final section without nodes. In the
+// GeoJSON formats, each component is written as a complete feature
+// collection on a single line, with its own line dictionary in compact mode.
+// The graph properties follow in a final feature collection without
+// features. LineGraph::readChunk() reads such a stream chunk by chunk,
+// LineGraph::readFromJson() merges all chunks into a single graph.
+//
+// Each chunk carries its running number in the "component" property of its
+// collection (or section) properties and of its features.
+class ComponentWriter {
+ public:
+  // format is one of json, json-compact, bin
+  ComponentWriter(std::ostream* out, const std::string& format);
+
+  ComponentWriter(const ComponentWriter&) = delete;
+  ComponentWriter& operator=(const ComponentWriter&) = delete;
+
+  void write(const LineGraph& g);
+
+  // write the graph properties and finish the output
+  void close(util::json::Dict props);
+
+  size_t numWritten() const { return _numWritten; }
+
+ private:
+  std::ostream* _out;
+  std::string _format;
+  size_t _numWritten;
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_COMPONENTWRITER_H_
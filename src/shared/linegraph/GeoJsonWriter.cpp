@@ -0,0 +1,369 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+#include "shared/linegraph/GeoJsonWriter.h"
+#include "shared/linegraph/LineGraph.h"
+
+using shared::linegraph::GeoJsonWriter;
+using shared::linegraph::LineGraph;
+using util::geo::DPoint;
+
+// buffered output is written to the stream in chunks of this size
+static const size_t BUF_SIZE = 1 << 16;
+
+// number of decimal places written for floating point values
+static const uint64_t FLOAT_SCALE = 10000000000ull;
+static const int FLOAT_PREC = 10;
+
+// _____________________________________________________________________________
+GeoJsonWriter::GeoJsonWriter(std::ostream* out)
+    : _out(out),
+      _sep(false),
+      _closed(false),
+      _lineDict(0),
+      _comp(std::numeric_limits<size_t>::max()) {
+  open(0);
+}
+
+// _____________________________________________________________________________
+GeoJsonWriter::GeoJsonWriter(std::ostream* out, const util::json::Dict& props)
+    : _out(out),
+      _sep(false),
+      _closed(false),
+      _lineDict(0),
+      _comp(std::numeric_limits<size_t>::max()) {
+  open(&props);
+}
+
+// _____________________________________________________________________________
+GeoJsonWriter::~GeoJsonWriter() { flush(); }
+
+// _____________________________________________________________________________
+void GeoJsonWriter::open(const util::json::Dict* props) {
+  _buf.reserve(BUF_SIZE + 1024);
+  _buf += "{\"type\":\"FeatureCollection\",";
+
+  if (props && props->size()) {
+    writeProps(*props);
+    _buf += ",";
+  }
+
+  _buf += "\"features\":[";
+  _sep = false;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeProps(const util::json::Dict& props) {
+  // graph properties are only written once, use the generic writer
+  std::stringstream ss;
+  util::json::Writer wr(&ss, false);
+  wr.val(props);
+  wr.closeAll();
+  _buf += "\"properties\":";
+  _buf += ss.str();
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::flush() {
+  if (!_closed) {
+    _buf += "]}\n";
+    _closed = true;
+  }
+  _out->write(_buf.data(), _buf.size());
+  _out->flush();
+  _buf.clear();
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::checkFlush() {
+  if (_buf.size() < BUF_SIZE) return;
+  _out->write(_buf.data(), _buf.size());
+  _buf.clear();
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::printLatLng(const LineGraph& g) {
+  for (auto n : g.getNds()) {
+    featureOpen("Point");
+    writeCoord(*n->pl().getGeom());
+    _buf += "},\"properties\":{";
+    _sep = false;
+
+    key("id");
+    valId(n);
+    key("deg");
+    strOpen();
+    writeUInt(n->getDeg());
+    strClose();
+
+    n->pl().writeAttrs(this);
+    featureClose();
+  }
+
+  for (auto n : g.getNds()) {
+    for (auto e : n->getAdjList()) {
+      // to avoid double output for undirected graphs
+      if (e->getFrom() != n) continue;
+
+      featureOpen("LineString");
+      _buf += '[';
+      const auto& line = e->pl().getPolyline().getLine();
+      if (line.size()) {
+        for (size_t i = 0; i < line.size(); i++) {
+          if (i) _buf += ',';
+          writeCoord(line[i]);
+        }
+      } else {
+        writeCoord(*e->getFrom()->pl().getGeom());
+        _buf += ',';
+        writeCoord(*e->getTo()->pl().getGeom());
+      }
+      _buf += "]},\"properties\":{";
+      _sep = false;
+
+      key("from");
+      valId(e->getFrom());
+      key("to");
+      valId(e->getTo());
+      key("id");
+      valId(e);
+
+      e->pl().writeAttrs(this);
+      featureClose();
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::featureOpen(const char* type) {
+  if (_sep) _buf += ',';
+  _buf += "{\"type\":\"Feature\",\"geometry\":{\"type\":\"";
+  _buf += type;
+  _buf += "\",\"coordinates\":";
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::featureClose() {
+  _buf += "}}";
+  _sep = true;
+  checkFlush();
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeCoord(const DPoint& p) {
+  auto ll = util::geo::webMercToLatLng<double>(p.getX(), p.getY());
+  _buf += '[';
+  writeDouble(ll.getX());
+  _buf += ',';
+  writeDouble(ll.getY());
+  _buf += ']';
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::obj() {
+  if (_sep) _buf += ',';
+  _buf += '{';
+  _closeStack += '}';
+  _sep = false;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::arr() {
+  if (_sep) _buf += ',';
+  _buf += '[';
+  _closeStack += ']';
+  _sep = false;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::close() {
+  // closes the innermost open object or array
+  _buf += _closeStack.back();
+  _closeStack.pop_back();
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::key(const std::string& k) {
+  if (_sep) _buf += ',';
+  writeStr(k);
+  _buf += ':';
+  _sep = false;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::val(const std::string& v) {
+  if (_sep) _buf += ',';
+  writeStr(v);
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::val(double v) {
+  if (_sep) _buf += ',';
+  writeDouble(v);
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::val(size_t v) {
+  if (_sep) _buf += ',';
+  writeUInt(v);
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::valId(const void* p) {
+  if (_sep) _buf += ',';
+  _buf += '"';
+  if (!p) {
+    _buf += '0';
+  } else {
+    static const char* HEX = "0123456789abcdef";
+    char tmp[2 * sizeof(uintptr_t)];
+    size_t n = 0;
+    uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    while (v) {
+      tmp[n++] = HEX[v & 0xF];
+      v >>= 4;
+    }
+    _buf += "0x";
+    while (n) _buf += tmp[--n];
+  }
+  _buf += '"';
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::keyVal(const std::string& k, const std::string& v) {
+  key(k);
+  val(v);
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::keyVal(const std::string& k, double v) {
+  key(k);
+  val(v);
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::keyVal(const std::string& k, size_t v) {
+  key(k);
+  val(v);
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::component(uint32_t comp) {
+  if (_comp != std::numeric_limits<size_t>::max()) {
+    keyVal("component", _comp);
+  } else if (comp != std::numeric_limits<uint32_t>::max()) {
+    keyVal("component", static_cast<size_t>(comp));
+  }
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::strOpen() {
+  if (_sep) _buf += ',';
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::strAppend(const std::string& v) { writeEscaped(v); }
+
+// _____________________________________________________________________________
+void GeoJsonWriter::strClose() {
+  _buf += '"';
+  _sep = true;
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeStr(const std::string& s) {
+  _buf += '"';
+  writeEscaped(s);
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeEscaped(const std::string& s) {
+  static const char* HEX = "0123456789abcdef";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        _buf += "\\\"";
+        break;
+      case '\\':
+        _buf += "\\\\";
+        break;
+      case '\n':
+        _buf += "\\n";
+        break;
+      case '\t':
+        _buf += "\\t";
+        break;
+      case '\r':
+        _buf += "\\r";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          _buf += "\\u00";
+          _buf += HEX[(c >> 4) & 0xF];
+          _buf += HEX[c & 0xF];
+        } else {
+          _buf += c;
+        }
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeUInt(uint64_t v) {
+  char tmp[20];
+  size_t n = 0;
+  do {
+    tmp[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v);
+  while (n) _buf += tmp[--n];
+}
+
+// _____________________________________________________________________________
+void GeoJsonWriter::writeDouble(double d) {
+  if (!std::isfinite(d)) {
+    _buf += "null";
+    return;
+  }
+
+  if (std::fabs(d) >= 1e8) {
+    // out of the range of the fixed point formatting below
+    char tmp[32];
+    int n = snprintf(tmp, sizeof(tmp), "%.*g", 17, d);
+    _buf.append(tmp, n);
+    return;
+  }
+
+  // fixed point formatting with FLOAT_PREC decimal places, trailing zeros
+  // are dropped
+  bool neg = d < 0;
+  uint64_t fixed = static_cast<uint64_t>(std::fabs(d) * FLOAT_SCALE + 0.5);
+  if (neg && fixed) _buf += '-';
+
+  writeUInt(fixed / FLOAT_SCALE);
+
+  uint64_t frac = fixed % FLOAT_SCALE;
+  if (frac) {
+    char digs[FLOAT_PREC];
+    for (int i = FLOAT_PREC - 1; i >= 0; i--) {
+      digs[i] = static_cast<char>('0' + frac % 10);
+      frac /= 10;
+    }
+    int len = FLOAT_PREC;
+    while (digs[len - 1] == '0') len--;
+    _buf += '.';
+    _buf.append(digs, len);
+  }
+}
@@ -0,0 +1,91 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_GEOJSONWRITER_H_
+#define SHARED_LINEGRAPH_GEOJSONWRITER_H_
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+
+#include "util/geo/Geo.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+class LineGraph;
+class LineDict;
+
+// Buffered streaming GeoJSON output of line graphs. Node and edge payloads
+// write their attributes directly into the output buffer via writeAttrs(),
+// no intermediate JSON trees are built per feature.
+class GeoJsonWriter {
+ public:
+  explicit GeoJsonWriter(std::ostream* out);
+  GeoJsonWriter(std::ostream* out, const util::json::Dict& props);
+  ~GeoJsonWriter();
+
+  // if set, edges reference lines by their index in this dictionary
+  void setLineDict(const LineDict* dict) { _lineDict = dict; }
+  const LineDict* getLineDict() const { return _lineDict; }
+
+  // if set, all following features are written with this component id
+  // instead of the component stored in their payloads
+  void setComponent(size_t comp) { _comp = comp; }
+
+  // write the component id of a feature, comp is the payload component
+  void component(uint32_t comp);
+
+  // print all nodes and edges of a graph, in lat/lng coordinates
+  void printLatLng(const LineGraph& g);
+
+  // close the feature collection and flush the buffer
+  void flush();
+
+  // attribute output
+  void obj();
+  void arr();
+  void close();
+  void key(const std::string& k);
+  void val(const std::string& v);
+  void val(double v);
+  void val(size_t v);
+  // graph element ids, written like util::toString() does
+  void valId(const void* p);
+  void keyVal(const std::string& k, const std::string& v);
+  void keyVal(const std::string& k, double v);
+  void keyVal(const std::string& k, size_t v);
+
+  // string values written in multiple parts
+  void strOpen();
+  void strAppend(const std::string& v);
+  void strClose();
+
+ private:
+  std::ostream* _out;
+  std::string _buf;
+  std::string _closeStack;
+  bool _sep;
+  bool _closed;
+  const LineDict* _lineDict;
+  size_t _comp;
+
+  void open(const util::json::Dict* props);
+  void writeProps(const util::json::Dict& props);
+  void writeStr(const std::string& s);
+  void writeEscaped(const std::string& s);
+  void writeDouble(double d);
+  void writeUInt(uint64_t v);
+  void writeCoord(const util::geo::DPoint& p);
+  void featureOpen(const char* type);
+  void featureClose();
+  void checkFlush();
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_GEOJSONWRITER_H_
@@ -0,0 +1,41 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <stdexcept>
+
+#include "shared/linegraph/LineDict.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineDict;
+
+// _____________________________________________________________________________
+size_t LineDict::add(const Line* l) {
+  auto i = _idx.find(l);
+  if (i != _idx.end()) return i->second;
+
+  _lines.push_back(l);
+  _idx[l] = _lines.size() - 1;
+  return _lines.size() - 1;
+}
+
+// _____________________________________________________________________________
+size_t LineDict::getIdx(const Line* l) const {
+  auto i = _idx.find(l);
+  if (i == _idx.end())
+    throw std::runtime_error("Line " + l->id() + " not in line dictionary");
+  return i->second;
+}
+
+// _____________________________________________________________________________
+util::json::Array LineDict::toJson() const {
+  util::json::Array ret;
+  for (auto l : _lines) {
+    util::json::Dict line;
+    line["id"] = l->id();
+    line["label"] = l->label();
+    line["color"] = l->color();
+    ret.push_back(line);
+  }
+  return ret;
+}
@@ -0,0 +1,38 @@
+// Copyright 2017, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef SHARED_LINEGRAPH_LINEDICT_H_
+#define SHARED_LINEGRAPH_LINEDICT_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "shared/linegraph/Line.h"
+#include "util/json/Writer.h"
+
+namespace shared {
+namespace linegraph {
+
+// Dictionary of lines for compact GeoJSON output. The dictionary is written
+// once to the FeatureCollection properties, edges then reference lines by
+// their index in it.
+class LineDict {
+ public:
+  size_t add(const Line* l);
+
+  // throws if l was not added before
+  size_t getIdx(const Line* l) const;
+  size_t size() const { return _lines.size(); }
+
+  util::json::Array toJson() const;
+
+ private:
+  std::vector<const Line*> _lines;
+  std::unordered_map<const Line*, size_t> _idx;
+};
+
+}  // namespace linegraph
+}  // namespace shared
+
+#endif  // SHARED_LINEGRAPH_LINEDICT_H_
@@ -2,6 +2,8 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+
 #include "shared/linegraph/Line.h"
 #include "shared/linegraph/LineEdgePL.h"
 #include "shared/linegraph/LineGraph.h"
@@ -10,6 +12,8 @@
 #include "util/String.h"
 #include "util/geo/PolyLine.h"
 
+using shared::linegraph::GeoJsonWriter;
+using shared::linegraph::LineDict;
 using shared::linegraph::LineEdgePL;
 using shared::linegraph::LineNode;
 using shared::linegraph::LineOcc;
@@ -24,7 +28,7 @@ LineEdgePL::LineEdgePL(const PolyLine<double>& p)
 
 // _____________________________________________________________________________
 LineEdgePL::LineEdgePL(const LineEdgePL& other)
-    : _lineToIdx(other._lineToIdx),
+    : _lineIdx(other._lineIdx),
       _lines(other._lines),
       _dontContract(other._dontContract),
       _comp(other._comp),
@@ -32,7 +36,7 @@ LineEdgePL::LineEdgePL(const LineEdgePL& other)
 
 // _____________________________________________________________________________
 LineEdgePL::LineEdgePL(LineEdgePL&& other)
-    : _lineToIdx(std::move(other._lineToIdx)),
+    : _lineIdx(std::move(other._lineIdx)),
       _lines(std::move(other._lines)),
       _dontContract(other._dontContract),
       _comp(other._comp),
@@ -59,10 +63,9 @@ void LineEdgePL::setPolyline(const PolyLine<double>& p) { _p = p; }
 
 // _____________________________________________________________________________
 void LineEdgePL::addLine(const Line* r, const LineNode* dir,
-                         util::Nullable<shared::style::LineStyle> ls) {
-  auto f = _lineToIdx.find(r);
-  if (f != _lineToIdx.end()) {
-    size_t prevIdx = f->second;
+                         const shared::style::LineStyle* ls) {
+  size_t prevIdx = findLine(r);
+  if (prevIdx != _lines.size()) {
     const auto& prev = _lines[prevIdx];
     // the route is already present in both directions, ignore newly inserted
     if (prev.direction == 0) return;
@@ -76,22 +79,63 @@ void LineEdgePL::addLine(const Line* r, const LineNode* dir,
       return;
     }
   }
-  _lineToIdx[r] = _lines.size();
-  LineOcc occ(r, dir, ls);
-  _lines.push_back(occ);
+  _lines.push_back(LineOcc(r, dir, ls));
+
+  if (_lines.size() > LINE_IDX_MIN) {
+    if (_lineIdx.empty()) {
+      rebuildLineIdx();
+    } else {
+      std::pair<const Line*, uint32_t> idx(
+          r, static_cast<uint32_t>(_lines.size() - 1));
+      _lineIdx.insert(
+          std::lower_bound(_lineIdx.begin(), _lineIdx.end(), idx), idx);
+    }
+  }
 }
 
 // _____________________________________________________________________________
 void LineEdgePL::addLine(const Line* r, const LineNode* dir) {
-  addLine(r, dir, util::Nullable<shared::style::LineStyle>());
+  addLine(r, dir, 0);
 }
 
 // _____________________________________________________________________________
 void LineEdgePL::delLine(const Line* r) {
-  _lineToIdx[_lines.back().line] = _lineToIdx.find(r)->second;
-  _lines[_lineToIdx.find(r)->second] = _lines.back();
+  size_t idx = findLine(r);
+  if (idx == _lines.size()) return;
+  _lines[idx] = _lines.back();
   _lines.resize(_lines.size() - 1);
-  _lineToIdx.erase(r);
+  rebuildLineIdx();
+}
+
+// _____________________________________________________________________________
+size_t LineEdgePL::findLine(const Line* r) const {
+  if (_lineIdx.empty()) {
+    for (size_t i = 0; i < _lines.size(); i++) {
+      if (_lines[i].line == r) return i;
+    }
+    return _lines.size();
+  }
+
+  auto it = std::lower_bound(
+      _lineIdx.begin(), _lineIdx.end(),
+      std::pair<const Line*, uint32_t>(r, 0));
+  if (it == _lineIdx.end() || it->first != r) return _lines.size();
+  return it->second;
+}
+
+// _____________________________________________________________________________
+void LineEdgePL::rebuildLineIdx() {
+  _lineIdx.clear();
+  if (_lines.size() <= LINE_IDX_MIN) {
+    _lineIdx.shrink_to_fit();
+    return;
+  }
+
+  _lineIdx.reserve(_lines.size());
+  for (size_t i = 0; i < _lines.size(); i++) {
+    _lineIdx.push_back({_lines[i].line, static_cast<uint32_t>(i)});
+  }
+  std::sort(_lineIdx.begin(), _lineIdx.end());
 }
 
 // _____________________________________________________________________________
@@ -108,10 +152,10 @@ util::json::Dict LineEdgePL::getAttrs() const {
     line["id"] = r.line->id();
     line["label"] = r.line->label();
     line["color"] = r.line->color();
-    if (!r.style.isNull()) {
-      if (r.style.get().getCss().size()) line["style"] = r.style.get().getCss();
-      if (r.style.get().getOutlineCss().size())
-        line["outline-style"] = r.style.get().getOutlineCss();
+    if (r.style) {
+      if (r.style->getCss().size()) line["style"] = r.style->getCss();
+      if (r.style->getOutlineCss().size())
+        line["outline-style"] = r.style->getOutlineCss();
     }
 
     if (r.direction != 0) {
@@ -133,11 +177,62 @@ util::json::Dict LineEdgePL::getAttrs() const {
 }
 
 // _____________________________________________________________________________
-bool LineEdgePL::hasLine(const Line* l) const { return _lineToIdx.count(l); }
+void LineEdgePL::writeAttrs(GeoJsonWriter* w) const {
+  const LineDict* dict = w->getLineDict();
+
+  w->key("lines");
+  w->arr();
+  for (const auto& r : getLines()) {
+    if (dict && r.direction == 0 && !r.style) {
+      // compact form, plain reference into the line dictionary
+      w->val(dict->getIdx(r.line));
+      continue;
+    }
+
+    w->obj();
+    if (dict) {
+      w->keyVal("line", dict->getIdx(r.line));
+    } else {
+      w->keyVal("id", r.line->id());
+      w->keyVal("label", r.line->label());
+      w->keyVal("color", r.line->color());
+    }
+    if (r.style) {
+      if (r.style->getCss().size()) w->keyVal("style", r.style->getCss());
+      if (r.style->getOutlineCss().size())
+        w->keyVal("outline-style", r.style->getOutlineCss());
+    }
+    if (r.direction != 0) {
+      w->key("direction");
+      w->valId(r.direction);
+    }
+    w->close();
+  }
+  w->close();
+
+  if (!dict) {
+    w->key("dbg_lines");
+    w->strOpen();
+    bool first = true;
+    for (const auto& r : getLines()) {
+      if (!first) w->strAppend(",");
+      w->strAppend(r.line->label());
+      first = false;
+    }
+    w->strClose();
+  }
+
+  w->component(_comp);
+}
+
+// _____________________________________________________________________________
+bool LineEdgePL::hasLine(const Line* l) const {
+  return findLine(l) != _lines.size();
+}
 
 // _____________________________________________________________________________
 const LineOcc& LineEdgePL::lineOcc(const Line* l) const {
-  return _lines[_lineToIdx.find(l)->second];
+  return _lines[findLine(l)];
 }
 
 // _____________________________________________________________________________
@@ -145,7 +240,7 @@ const LineOcc& LineEdgePL::lineOccAtPos(size_t i) const { return _lines[i]; }
 
 // _____________________________________________________________________________
 void LineEdgePL::updateLineOcc(const LineOcc& occ) {
-  _lines[_lineToIdx.find(occ.line)->second] = occ;
+  _lines[findLine(occ.line)] = occ;
 }
 
 // _____________________________________________________________________________
@@ -153,14 +248,14 @@ void LineEdgePL::writePermutation(const std::vector<size_t> order) {
   std::vector<LineOcc> linesNew(_lines.size());
   for (size_t i = 0; i < order.size(); i++) {
     linesNew[i] = _lines[order[i]];
-    _lineToIdx[_lines[order[i]].line] = i;
   }
   _lines = linesNew;
+  rebuildLineIdx();
 }
 
 // _____________________________________________________________________________
 size_t LineEdgePL::linePos(const Line* r) const {
-  auto it = _lineToIdx.find(r);
-  if (it == _lineToIdx.end()) return -1;
-  return it->second;
+  size_t idx = findLine(r);
+  if (idx == _lines.size()) return -1;
+  return idx;
 }
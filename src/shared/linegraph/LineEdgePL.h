@@ -5,9 +5,12 @@
 #ifndef SHARED_LINEGRAPH_LINEEDGEPL_H_
 #define SHARED_LINEGRAPH_LINEEDGEPL_H_
 
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "shared/linegraph/Line.h"
+#include "shared/linegraph/GeoJsonWriter.h"
+#include "shared/linegraph/LineDict.h"
 #include "shared/style/LineStyle.h"
 #include "util/Nullable.h"
 #include "util/geo/GeoGraph.h"
@@ -25,16 +28,17 @@ class LineEdgePL;
 class LineNodePL;
 
 struct LineOcc {
-  LineOcc() {}
+  LineOcc() : line(0), direction(0), style(0) {}
   LineOcc(const Line* r, const Node<LineNodePL, LineEdgePL>* dir)
-      : line(r), direction(dir) {}
+      : line(r), direction(dir), style(0) {}
   LineOcc(const Line* r, const Node<LineNodePL, LineEdgePL>* dir,
-          const util::Nullable<shared::style::LineStyle>& ls)
+          const shared::style::LineStyle* ls)
       : line(r), direction(dir), style(ls) {}
   const Line* line;
   const Node<LineNodePL, LineEdgePL>* direction;  // 0 if in both directions
 
-  util::Nullable<shared::style::LineStyle> style;
+  // interned via LineStyle::intern(), 0 if no custom style
+  const shared::style::LineStyle* style;
 };
 
 inline bool operator<(const LineOcc& x, const LineOcc& y) {
@@ -49,7 +53,7 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   LineEdgePL(LineEdgePL&& other);
 
   LineEdgePL& operator=(LineEdgePL&& other) {
-    _lineToIdx = std::move(other._lineToIdx);
+    _lineIdx = std::move(other._lineIdx);
     _lines = std::move(other._lines);
     _dontContract = other._dontContract;
     _comp = other._comp;
@@ -58,7 +62,7 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   }
 
   LineEdgePL& operator=(const LineEdgePL& other) {
-    _lineToIdx = other._lineToIdx;
+    _lineIdx = other._lineIdx;
     _lines = other._lines;
     _dontContract = other._dontContract;
     _comp = other._comp;
@@ -67,7 +71,7 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   }
 
   void addLine(const Line* r, const Node<LineNodePL, LineEdgePL>* dir,
-               util::Nullable<shared::style::LineStyle> ls);
+               const shared::style::LineStyle* ls);
   void addLine(const Line* r, const Node<LineNodePL, LineEdgePL>* dir);
 
   const std::vector<LineOcc>& getLines() const;
@@ -85,6 +89,7 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   const util::geo::Line<double>* getGeom() const;
   void setGeom(const util::geo::Line<double>& l);
   util::json::Dict getAttrs() const;
+  void writeAttrs(GeoJsonWriter* w) const;
 
   const PolyLine<double>& getPolyline() const;
   PolyLine<double>& getPolyline();
@@ -96,15 +101,24 @@ class LineEdgePL : util::geograph::GeoEdgePL<double> {
   void writePermutation(const std::vector<size_t> order);
 
   void setDontContract(bool dontContract) { _dontContract = dontContract; }
-  bool dontContract() { return _dontContract; }
+  bool dontContract() const { return _dontContract; }
 
  private:
-  std::unordered_map<const Line*, size_t> _lineToIdx;
+  // edges with at most this many lines are searched linearly and carry no
+  // line index at all
+  static const size_t LINE_IDX_MIN = 8;
+
+  // sorted (line, position in _lines) pairs, only filled if the edge holds
+  // more than LINE_IDX_MIN lines
+  std::vector<std::pair<const Line*, uint32_t>> _lineIdx;
   std::vector<LineOcc> _lines;
   bool _dontContract;
   uint32_t _comp = std::numeric_limits<uint32_t>::max();
 
   PolyLine<double> _p;
+
+  size_t findLine(const Line* r) const;
+  void rebuildLineIdx();
 };
 }  // namespace linegraph
 }  // namespace shared
@@ -4,17 +4,18 @@
 
 #include "3rdparty/json.hpp"
 #include "dot/Parser.h"
+#include "shared/linegraph/BinGraphView.h"
 #include "shared/linegraph/LineEdgePL.h"
 #include "shared/linegraph/LineGraph.h"
 #include "shared/linegraph/LineNodePL.h"
 #include "shared/style/LineStyle.h"
 #include "util/Misc.h"
 #include "util/String.h"
-#include "util/graph/Algorithm.h"
 #include "util/graph/Edge.h"
 #include "util/graph/Node.h"
 #include "util/log/Log.h"
 
+using shared::linegraph::BinGraphView;
 using shared::linegraph::EdgeGrid;
 using shared::linegraph::EdgeOrdering;
 using shared::linegraph::ISect;
@@ -28,7 +29,9 @@ using shared::linegraph::Partner;
 using util::randomHtmlColor;
 using util::geo::DPoint;
 using util::geo::Point;
-using util::graph::Algorithm;
+
+// number of GeoJSON features prepared in parallel at once
+static const size_t GEOJSON_BATCH_SIZE = 4096;
 
 // _____________________________________________________________________________
 void LineGraph::readFromDot(std::istream* s) {
@@ -167,233 +170,540 @@ void LineGraph::readFromTopoJson(nlohmann::json::array_t objects,
 }
 
 // _____________________________________________________________________________
-void LineGraph::readFromGeoJson(nlohmann::json::array_t features) {
+void LineGraph::readFromGeoJson(const nlohmann::json::array_t& features) {
   return readFromGeoJson(features, false);
 }
 
 // _____________________________________________________________________________
-void LineGraph::readFromGeoJson(nlohmann::json::array_t features,
+void LineGraph::readFromGeoJson(const nlohmann::json::array_t& features,
                                 bool webMercCoords) {
   _bbox = util::geo::Box<double>();
 
-  std::map<std::string, LineNode*> idMap;
+  GeoJsonReadState st;
+  std::vector<GeoJsonFeature> batch;
 
-  for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "Point") {
-      std::string id;
-      if (props.count("id")) id = props["id"].get<std::string>();
+  // features are copied out of the DOM batch-wise, as in readFromJson()
+  for (const auto& feature : features) {
+    batch.push_back(GeoJsonFeature());
+    batch.back().json = feature;
+    if (batch.size() == GEOJSON_BATCH_SIZE)
+      readGeoJsonBatch(&batch, webMercCoords, &st);
+  }
 
-      std::vector<double> coords = geom["coordinates"];
+  readGeoJsonBatch(&batch, webMercCoords, &st);
 
-      util::geo::DPoint point(coords[0], coords[1]);
-      if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
+  for (auto& f : st.pendingEdgs) readGeoJsonEdg(&f, true, &st);
+  for (auto& feature : st.pendingExcs)
+    readGeoJsonExcs(feature, webMercCoords, &st);
 
-      if (id.empty()) {
-        id = std::to_string(static_cast<int>(point.getX())) + "|" +
-             std::to_string(static_cast<int>(point.getY()));
-      }
+  _bbox = util::geo::pad(_bbox, 100);
 
-      if (idMap.count(id)) continue;
+  buildGrids();
+}
 
-      LineNode* n = addNd({point, std::numeric_limits<uint32_t>::max()});
-      expandBBox(*n->pl().getGeom());
+// _____________________________________________________________________________
+std::string LineGraph::getGeoJsonNdId(nlohmann::json& feature,
+                                      bool webMercCoords) const {
+  auto& props = feature["properties"];
+  auto& geom = feature["geometry"];
 
-      if (props["component"].is_number())
-        n->pl().setComponent(props["component"].get<size_t>());
+  std::string id;
+  if (props.count("id")) id = props["id"].get<std::string>();
 
-      Station i("", "", *n->pl().getGeom());
+  if (id.empty()) {
+    std::vector<double> coords = geom["coordinates"];
 
-      std::string sid = getStationId(props);
-      std::string label = getStationLabel(props);
-      if (!sid.empty() || !label.empty()) {
-        i.id = sid;
-        i.name = label;
+    util::geo::DPoint point(coords[0], coords[1]);
+    if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
 
-        n->pl().addStop(i);
-      }
+    id = std::to_string(static_cast<int>(point.getX())) + "|" +
+         std::to_string(static_cast<int>(point.getY()));
+  }
+
+  return id;
+}
+
+// _____________________________________________________________________________
+void LineGraph::prepGeoJsonFeature(bool webMercCoords,
+                                   GeoJsonFeature* f) const {
+  // only reads and writes the feature itself, safe to call in parallel
+  auto& props = f->json["properties"];
+  auto& geom = f->json["geometry"];
+
+  if (props["component"].is_number())
+    f->component = props["component"].get<size_t>();
+
+  if (geom["type"] == "Point") {
+    f->isNd = true;
+
+    std::vector<double> coords = geom["coordinates"];
+
+    f->point = util::geo::DPoint(coords[0], coords[1]);
+    if (!webMercCoords) f->point = util::geo::latLngToWebMerc(f->point);
 
-      idMap[id] = n;
+    f->id = getGeoJsonNdId(f->json, webMercCoords);
+  } else if (geom["type"] == "LineString") {
+    f->isEdg = true;
+
+    f->from = props["from"].is_null() ? "" : props["from"].get<std::string>();
+    f->to = props["to"].is_null() ? "" : props["to"].get<std::string>();
+
+    if (geom["coordinates"].is_null()) return;
+
+    for (const auto& coord : geom["coordinates"]) {
+      Point<double> p(coord[0].get<double>(), coord[1].get<double>());
+      if (!webMercCoords) p = util::geo::latLngToWebMerc(p);
+      f->pl << p;
+      f->box = util::geo::extendBox(p, f->box);
+    }
+
+    if (f->pl.getLine().empty()) return;
+
+    if (f->from.empty()) {
+      f->from = std::to_string(static_cast<int>(f->pl.front().getX())) + "|" +
+                std::to_string(static_cast<int>(f->pl.front().getY()));
+      f->implFrom = true;
+    }
+
+    if (f->to.empty()) {
+      f->to = std::to_string(static_cast<int>(f->pl.back().getX())) + "|" +
+              std::to_string(static_cast<int>(f->pl.back().getY()));
+      f->implTo = true;
     }
   }
+}
 
-  // second pass, edges
-  for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "LineString") {
-      std::string from =
-          props["from"].is_null() ? "" : props["from"].get<std::string>();
-      std::string to =
-          props["to"].is_null() ? "" : props["to"].get<std::string>();
+// _____________________________________________________________________________
+void LineGraph::readGeoJsonBatch(std::vector<GeoJsonFeature>* batch,
+                                 bool webMercCoords, GeoJsonReadState* st) {
+  // coordinates are parsed and projected in parallel, the features are then
+  // added to the graph in input order, so node and edge creation order does
+  // not depend on the number of threads
+#pragma omp parallel for schedule(dynamic, 64)
+  for (size_t i = 0; i < batch->size(); i++)
+    prepGeoJsonFeature(webMercCoords, &(*batch)[i]);
+
+  for (auto& f : *batch) {
+    if (f.isNd) {
+      readGeoJsonNd(&f, st);
+      auto& props = f.json["properties"];
+      if (!props["not_serving"].is_null() || !props["excluded_conn"].is_null())
+        st->pendingExcs.push_back(std::move(f.json));
+    } else if (f.isEdg) {
+      if (!readGeoJsonEdg(&f, false, st))
+        st->pendingEdgs.push_back(std::move(f));
+    }
+  }
 
-      if (geom["coordinates"].is_null()) continue;
+  batch->clear();
+}
 
-      std::vector<std::vector<double>> coords = geom["coordinates"];
+// _____________________________________________________________________________
+void LineGraph::readGeoJsonNd(GeoJsonFeature* f, GeoJsonReadState* st) {
+  auto& props = f->json["properties"];
 
-      size_t component = std::numeric_limits<uint32_t>::max();
+  LineNode* n = 0;
 
-      if (props["component"].is_number())
-        component = props["component"].get<size_t>();
+  auto ex = st->idMap.find(f->id);
+  if (ex != st->idMap.end()) {
+    // a node which has already been implicitly created by an edge end point,
+    // take over the position and the station of this feature
+    if (!st->implNds.count(ex->second)) return;
+    n = ex->second;
+    st->implNds.erase(n);
+    n->pl().setGeom(f->point);
+  } else {
+    n = addNd({f->point, std::numeric_limits<uint32_t>::max()});
+  }
 
-      PolyLine<double> pl;
-      for (auto coord : coords) {
-        double x = coord[0], y = coord[1];
-        Point<double> p(x, y);
-        if (!webMercCoords) p = util::geo::latLngToWebMerc(p);
-        pl << p;
-        expandBBox(p);
+  expandBBox(*n->pl().getGeom());
+
+  if (props["component"].is_number())
+    n->pl().setComponent(props["component"].get<size_t>());
+
+  Station i("", "", *n->pl().getGeom());
+
+  std::string sid =
+      getStationId(props.get_ref<const nlohmann::json::object_t&>());
+  std::string label =
+      getStationLabel(props.get_ref<const nlohmann::json::object_t&>());
+  if (!sid.empty() || !label.empty()) {
+    i.id = sid;
+    i.name = label;
+
+    n->pl().addStop(i);
+  }
+
+  st->idMap[f->id] = n;
+}
+
+// _____________________________________________________________________________
+bool LineGraph::readGeoJsonEdg(GeoJsonFeature* f, bool force,
+                               GeoJsonReadState* st) {
+  auto& props = f->json["properties"];
+
+  // referenced nodes or the line dictionary may not have been read yet
+  if (!force &&
+      ((!f->from.empty() && !f->implFrom && !st->idMap.count(f->from)) ||
+       (!f->to.empty() && !f->implTo && !st->idMap.count(f->to)) ||
+       (!st->hasLineDict && refsLineDict(props)))) {
+    return false;
+  }
+
+  if (f->json["geometry"]["coordinates"].is_null()) return true;
+
+  if (!f->pl.getLine().empty()) {
+    expandBBox(f->box.getLowerLeft());
+    expandBBox(f->box.getUpperRight());
+  }
+
+  if (f->implFrom && !st->idMap.count(f->from)) {
+    st->idMap[f->from] = addNd({f->pl.getLine().front(), f->component});
+    st->implNds.insert(st->idMap[f->from]);
+  }
+
+  if (f->implTo && !st->idMap.count(f->to)) {
+    st->idMap[f->to] = addNd({f->pl.getLine().back(), f->component});
+    st->implNds.insert(st->idMap[f->to]);
+  }
+
+  auto frIt = st->idMap.find(f->from);
+  if (frIt == st->idMap.end() || !frIt->second) {
+    LOG(ERROR) << "Node \"" << f->from << "\" not found.";
+    return true;
+  }
+
+  auto toIt = st->idMap.find(f->to);
+  if (toIt == st->idMap.end() || !toIt->second) {
+    LOG(ERROR) << "Node \"" << f->to << "\" not found.";
+    return true;
+  }
+
+  LineNode* fromN = frIt->second;
+  LineNode* toN = toIt->second;
+
+  if (fromN == toN) {
+    LOGTO(DEBUG, std::cerr) << "Self edges are not supported, dropping...";
+    return true;
+  }
+
+  LineEdge* e = addEdg(fromN, toN, f->pl);
+
+  e->pl().setComponent(f->component);
+
+  if (props["dontcontract"].is_number() && props["dontcontract"].get<int>())
+    e->pl().setDontContract(true);
+
+  extractLines(props.get_ref<const nlohmann::json::object_t&>(), e, st->idMap,
+               st->lineDict);
+
+  // if no lines were extracted, completely delete edge
+  if (e->pl().getLines().empty()) delEdg(e->getFrom(), e->getTo());
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void LineGraph::readGeoJsonExcs(nlohmann::json& feature, bool webMercCoords,
+                                GeoJsonReadState* st) {
+  auto& props = feature["properties"];
+
+  std::string id = getGeoJsonNdId(feature, webMercCoords);
+
+  if (!st->idMap.count(id)) return;
+  LineNode* n = st->idMap[id];
+
+  if (!props["not_serving"].is_null()) {
+    for (const auto& excl : props["not_serving"]) {
+      std::string lid = excl.get<std::string>();
+
+      const Line* r = getLine(lid);
+
+      if (!r) {
+        LOG(WARN) << "line " << lid << " marked as not served in in node "
+                  << id << ", but no such line exists.";
+        continue;
       }
 
-      if (from.empty()) {
-        from = std::to_string(static_cast<int>(pl.front().getX())) + "|" +
-               std::to_string(static_cast<int>(pl.front().getY()));
-        if (!idMap.count(from))
-          idMap[from] = addNd({pl.getLine().front(), component});
+      n->pl().addLineNotServed(r);
+    }
+  }
+
+  if (!props["excluded_conn"].is_null()) {
+    for (const auto& excl : props["excluded_conn"]) {
+      std::string lid = excl["line"].get<std::string>();
+      std::string nid1 = excl["node_from"].get<std::string>();
+      std::string nid2 = excl["node_to"].get<std::string>();
+
+      const Line* r = getLine(lid);
+
+      if (!r) {
+        LOG(WARN) << "line connection exclude defined in node " << id
+                  << " for line " << lid << ", but no such line exists.";
+        continue;
       }
 
-      if (to.empty()) {
-        to = std::to_string(static_cast<int>(pl.back().getX())) + "|" +
-             std::to_string(static_cast<int>(pl.back().getY()));
-        if (!idMap.count(to))
-          idMap[to] = addNd({pl.getLine().back(), component});
+      if (!st->idMap.count(nid1)) {
+        LOG(WARN) << "line connection exclude defined in node " << id
+                  << " for edge from " << nid1 << ", but no such node exists.";
+        continue;
       }
 
-      // pl.applyChaikinSmooth(3);
+      if (!st->idMap.count(nid2)) {
+        LOG(WARN) << "line connection exclude defined in node " << id
+                  << " for edge from " << nid2 << ", but no such node exists.";
+        continue;
+      }
 
-      LineNode* fromN = 0;
-      LineNode* toN = 0;
+      LineNode* n1 = st->idMap[nid1];
+      LineNode* n2 = st->idMap[nid2];
 
-      if (from.size()) {
-        fromN = idMap[from];
-        if (!fromN) {
-          LOG(ERROR) << "Node \"" << from << "\" not found.";
-          continue;
-        }
-      } else {
-        fromN = addNd({pl.getLine().front(), component});
-      }
+      LineEdge* a = getEdg(n, n1);
+      LineEdge* b = getEdg(n, n2);
 
-      if (to.size()) {
-        toN = idMap[to];
-        if (!toN) {
-          LOG(ERROR) << "Node \"" << to << "\" not found.";
-          continue;
-        }
-      } else {
-        toN = addNd({pl.getLine().back(), component});
+      if (!a) {
+        LOG(WARN) << "line connection exclude defined in node " << id
+                  << " for edge from " << nid1 << ", but no such edge exists.";
+        continue;
       }
 
-      if (fromN == toN) {
-        LOGTO(DEBUG, std::cerr) << "Self edges are not supported, dropping...";
+      if (!b) {
+        LOG(WARN) << "line connection exclude defined in node " << id
+                  << " for edge from " << nid2 << ", but no such edge exists.";
         continue;
       }
 
-      LineEdge* e = addEdg(fromN, toN, pl);
+      n->pl().addConnExc(r, a, b);
+    }
+  }
+}
 
-      e->pl().setComponent(component);
+// _____________________________________________________________________________
+void LineGraph::readFromJson(std::istream* s) { return readFromJson(s, false); }
 
-      if (props["dontcontract"].is_number() && props["dontcontract"].get<int>())
-        e->pl().setDontContract(true);
+// _____________________________________________________________________________
+void LineGraph::readFromJson(std::istream* s, bool useWebMercCoords) {
+  // binary graph streams are accepted transparently
+  if (bin::isBin(s)) return readFromBin(s);
+
+  _bbox = util::geo::Box<double>();
 
-      extractLines(props, e, idMap);
+  // a stream may contain multiple concatenated feature collections, as
+  // written by ComponentWriter, which are merged
+  bool geoJson = false;
+  while (readJsonDoc(s, useWebMercCoords, &geoJson)) {
+  }
 
-      // if no lines were extracted, completely delete edge
-      if (e->pl().getLines().empty()) delEdg(e->getFrom(), e->getTo());
+  if (geoJson) {
+    _bbox = util::geo::pad(_bbox, 100);
+    buildGrids();
+  }
+}
+
+// _____________________________________________________________________________
+bool LineGraph::readChunk(std::istream* s) {
+  if (bin::isBin(s)) return readBinSection(s);
+
+  _bbox = util::geo::Box<double>();
+
+  bool geoJson = false;
+  if (!readJsonDoc(s, false, &geoJson)) return false;
+
+  if (geoJson) {
+    _bbox = util::geo::pad(_bbox, 100);
+    buildGrids();
+  }
+
+  return true;
+}
+
+// _____________________________________________________________________________
+bool LineGraph::readJsonDoc(std::istream* s, bool useWebMercCoords,
+                            bool* geoJson) {
+  *s >> std::ws;
+  if (s->peek() == std::char_traits<char>::eof()) return false;
+
+  GeoJsonReadState st;
+  std::string topKey;
+  std::vector<GeoJsonFeature> batch;
+
+  // GeoJSON features are moved out of the DOM as soon as they have been
+  // parsed and are added to the graph in batches, so only a single batch is
+  // held in memory at once. Edges referencing nodes not read yet and nodes
+  // carrying line exceptions are kept until the end of the document.
+  nlohmann::json::parser_callback_t cb =
+      [&](int depth, nlohmann::json::parse_event_t ev,
+          nlohmann::json& parsed) -> bool {
+    if (depth == 1 && ev == nlohmann::json::parse_event_t::key) {
+      topKey = parsed.get<std::string>();
+    } else if (depth == 1 && ev == nlohmann::json::parse_event_t::object_end &&
+               topKey == "properties") {
+      if (parsed.count("lines")) readLineDict(parsed["lines"], &st);
+    } else if (depth == 2 && ev == nlohmann::json::parse_event_t::object_end &&
+               topKey == "features") {
+      batch.push_back(GeoJsonFeature());
+      batch.back().json = std::move(parsed);
+      if (batch.size() == GEOJSON_BATCH_SIZE)
+        readGeoJsonBatch(&batch, useWebMercCoords, &st);
+      return false;
+    }
+    return true;
+  };
+
+  // the document is parsed non-strictly, which stops right after its end
+  // instead of requiring the end of the stream
+  nlohmann::json j;
+  nlohmann::detail::parser<nlohmann::json,
+                           nlohmann::detail::input_stream_adapter>(
+      nlohmann::detail::input_adapter(*s), cb, true)
+      .parse(false, j);
+
+  if (j["type"] == "FeatureCollection") {
+    *geoJson = true;
+
+    readGeoJsonBatch(&batch, useWebMercCoords, &st);
+
+    for (auto& f : st.pendingEdgs) readGeoJsonEdg(&f, true, &st);
+    for (auto& feature : st.pendingExcs)
+      readGeoJsonExcs(feature, useWebMercCoords, &st);
+
+    if (j.count("properties")) {
+      for (const auto& kv : j["properties"].items())
+        _graphProps[kv.key()] = kv.value();
     }
+
+    // the line dictionary and the component id are only meaningful for
+    // this document
+    _graphProps.erase("lines");
+    _graphProps.erase("component");
+  }
+  if (j["type"] == "Topology")
+    readFromTopoJson(j["objects"], j["arcs"], useWebMercCoords);
+
+  return true;
+}
+
+// _____________________________________________________________________________
+void LineGraph::readFromBin(std::istream* s) {
+  // a stream may contain multiple graph sections, which are merged
+  std::vector<std::vector<uint64_t>> bufs;
+  std::vector<bin::Section> secs;
+
+  while (bin::isBin(s)) {
+    bufs.push_back(std::vector<uint64_t>());
+    secs.push_back(readBinSectionBuf(s, &bufs.back()));
   }
 
-  // third pass, exceptions (TODO: do this in the first part, store in some
-  // data structure, add here!)
-  for (auto feature : features) {
-    auto props = feature["properties"];
-    auto geom = feature["geometry"];
-    if (geom["type"] == "Point") {
-      std::string id;
-      if (props.count("id")) id = props["id"].get<std::string>();
+  readFromBin(secs);
+}
 
-      if (id.empty()) {
-        std::vector<double> coords = geom["coordinates"];
+// _____________________________________________________________________________
+bool LineGraph::readBinSection(std::istream* s) {
+  if (!bin::isBin(s)) return false;
 
-        util::geo::DPoint point(coords[0], coords[1]);
-        if (!webMercCoords) point = util::geo::latLngToWebMerc(point);
+  std::vector<uint64_t> buf;
+  readFromBin({readBinSectionBuf(s, &buf)});
 
-        id = std::to_string(static_cast<int>(point.getX())) + "|" +
-             std::to_string(static_cast<int>(point.getY()));
-      }
+  return true;
+}
 
-      if (!idMap.count(id)) continue;
-      LineNode* n = idMap[id];
+// _____________________________________________________________________________
+shared::linegraph::bin::Section LineGraph::readBinSectionBuf(
+    std::istream* s, std::vector<uint64_t>* buf) {
+  bin::Header h;
+  s->read(reinterpret_cast<char*>(&h), sizeof(h));
+  if (!*s || !bin::validHeader(h))
+    throw std::runtime_error("Invalid or unsupported binary graph header.");
+
+  // 8-byte aligned buffer holding the complete section
+  size_t size = bin::sectionSize(h);
+  buf->resize(size / sizeof(uint64_t));
+  char* data = reinterpret_cast<char*>(buf->data());
+  memcpy(data, &h, sizeof(h));
+  s->read(data + sizeof(h), size - sizeof(h));
+  if (!*s) throw std::runtime_error("Unexpected end of binary graph stream.");
+
+  return bin::mapSection(data);
+}
 
-      if (!props["not_serving"].is_null()) {
-        for (auto excl : props["not_serving"]) {
-          std::string lid = excl.get<std::string>();
+// _____________________________________________________________________________
+void LineGraph::readFromBin(const std::vector<bin::Section>& secs) {
+  _bbox = util::geo::Box<double>();
 
-          const Line* r = getLine(lid);
+  for (const auto& sec : secs) {
+    const auto& h = *sec.header;
 
-          if (!r) {
-            LOG(WARN) << "line " << lid << " marked as not served in in node "
-                      << id << ", but no such line exists.";
-            continue;
-          }
+    bin::checkSection(sec);
 
-          n->pl().addLineNotServed(r);
-        }
+    std::vector<const Line*> lines(h.numLines);
+    for (size_t i = 0; i < h.numLines; i++) {
+      std::string id = sec.str(sec.lines[i].id);
+      lines[i] = getLine(id);
+      if (!lines[i]) {
+        lines[i] = new Line(id, sec.str(sec.lines[i].label),
+                            sec.str(sec.lines[i].color));
+        addLine(lines[i]);
       }
+    }
 
-      if (!props["excluded_conn"].is_null()) {
-        for (auto excl : props["excluded_conn"]) {
-          std::string lid = excl["line"].get<std::string>();
-          std::string nid1 = excl["node_from"].get<std::string>();
-          std::string nid2 = excl["node_to"].get<std::string>();
+    std::vector<const shared::style::LineStyle*> styles(h.numStyles);
+    for (size_t i = 0; i < h.numStyles; i++) {
+      shared::style::LineStyle ls;
+      ls.setCss(sec.str(sec.styles[i].css));
+      ls.setOutlineCss(sec.str(sec.styles[i].outlineCss));
+      styles[i] = shared::style::LineStyle::intern(ls);
+    }
 
-          const Line* r = getLine(lid);
+    std::vector<LineNode*> nds(h.numNds);
+    for (size_t i = 0; i < h.numNds; i++) {
+      const auto& rec = sec.nds[i];
+      nds[i] = addNd({DPoint(rec.x, rec.y), rec.comp});
+      expandBBox(*nds[i]->pl().getGeom());
 
-          if (!r) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for line " << lid << ", but no such line exists.";
-            continue;
-          }
+      for (size_t j = rec.firstStop; j < rec.firstStop + rec.numStops; j++) {
+        const auto& stop = sec.stops[j];
+        nds[i]->pl().addStop(Station(sec.str(stop.id), sec.str(stop.name),
+                                     DPoint(stop.x, stop.y)));
+      }
 
-          if (!idMap.count(nid1)) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid1
-                      << ", but no such node exists.";
-            continue;
-          }
+      for (size_t j = rec.firstNotServed;
+           j < rec.firstNotServed + rec.numNotServed; j++) {
+        nds[i]->pl().addLineNotServed(lines[sec.notServed[j]]);
+      }
+    }
 
-          if (!idMap.count(nid2)) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid2
-                      << ", but no such node exists.";
-            continue;
-          }
+    std::vector<LineEdge*> edgs(h.numEdgs);
+    for (size_t i = 0; i < h.numEdgs; i++) {
+      const auto& rec = sec.edgs[i];
 
-          LineNode* n1 = idMap[nid1];
-          LineNode* n2 = idMap[nid2];
+      auto pl = BinGraphView::edgGeom(sec, i);
+      for (const auto& p : pl.getLine()) expandBBox(p);
 
-          LineEdge* a = getEdg(n, n1);
-          LineEdge* b = getEdg(n, n2);
+      auto e = addEdg(nds[rec.from], nds[rec.to], pl);
+      edgs[i] = e;
 
-          if (!a) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid1
-                      << ", but no such edge exists.";
-            continue;
-          }
+      e->pl().setComponent(rec.comp);
+      if (rec.flags & bin::EDG_DONT_CONTRACT) e->pl().setDontContract(true);
 
-          if (!b) {
-            LOG(WARN) << "line connection exclude defined in node " << id
-                      << " for edge from " << nid2
-                      << ", but no such edge exists.";
-            continue;
-          }
+      for (size_t j = rec.firstOcc; j < rec.firstOcc + rec.numOccs; j++) {
+        const auto& occ = sec.occs[j];
+        e->pl().addLine(lines[occ.line],
+                        occ.dir == bin::NONE ? 0 : nds[occ.dir],
+                        occ.style == bin::NONE ? 0 : styles[occ.style]);
+      }
+    }
 
-          n->pl().addConnExc(r, a, b);
-        }
+    for (size_t i = 0; i < h.numNds; i++) {
+      const auto& rec = sec.nds[i];
+      for (size_t j = rec.firstExc; j < rec.firstExc + rec.numExcs; j++) {
+        const auto& exc = sec.excs[j];
+        nds[i]->pl().addConnExc(lines[exc.line], edgs[exc.edgA],
+                                edgs[exc.edgB]);
       }
     }
+
+    std::string props = sec.str(h.props);
+    if (!props.empty()) _graphProps = nlohmann::json::parse(props);
   }
 
   _bbox = util::geo::pad(_bbox, 100);
@@ -402,19 +712,199 @@ void LineGraph::readFromGeoJson(nlohmann::json::array_t features,
 }
 
 // _____________________________________________________________________________
-void LineGraph::readFromJson(std::istream* s) { return readFromJson(s, false); }
+void LineGraph::writeToBin(std::ostream* s,
+                           const util::json::Dict& props) const {
+  std::stringstream ss;
+  util::json::Writer wr(&ss, false);
+  wr.val(props);
+  wr.closeAll();
+  writeToBin(s, nlohmann::json::parse(ss.str()));
+}
 
 // _____________________________________________________________________________
-void LineGraph::readFromJson(std::istream* s, bool useWebMercCoords) {
-  nlohmann::json j;
-  (*s) >> j;
+void LineGraph::writeToBin(std::ostream* s, const nlohmann::json& props) const {
+  std::vector<uint64_t> strOffs{0};
+  std::vector<char> strData;
+  std::unordered_map<std::string, uint32_t> strIds;
+
+  auto str = [&](const std::string& str) -> uint32_t {
+    auto i = strIds.find(str);
+    if (i != strIds.end()) return i->second;
+    strData.insert(strData.end(), str.begin(), str.end());
+    strOffs.push_back(strData.size());
+    return strIds[str] = static_cast<uint32_t>(strOffs.size() - 2);
+  };
+
+  std::vector<bin::LineRec> lines;
+  std::unordered_map<const Line*, uint32_t> lineIds;
+
+  auto line = [&](const Line* l) -> uint32_t {
+    auto i = lineIds.find(l);
+    if (i != lineIds.end()) return i->second;
+    lines.push_back({str(l->id()), str(l->label()), str(l->color())});
+    return lineIds[l] = static_cast<uint32_t>(lines.size() - 1);
+  };
+
+  std::vector<bin::StyleRec> styles;
+  std::unordered_map<const shared::style::LineStyle*, uint32_t> styleIds;
+
+  auto style = [&](const shared::style::LineStyle* ls) -> uint32_t {
+    if (!ls) return bin::NONE;
+    auto i = styleIds.find(ls);
+    if (i != styleIds.end()) return i->second;
+    styles.push_back({str(ls->getCss()), str(ls->getOutlineCss())});
+    return styleIds[ls] = static_cast<uint32_t>(styles.size() - 1);
+  };
+
+  std::unordered_map<const LineNode*, uint32_t> ndIds;
+  std::unordered_map<const LineEdge*, uint32_t> edgIds;
 
-  if (j["type"] == "FeatureCollection") {
-    readFromGeoJson(j["features"], useWebMercCoords);
-    if (j.count("properties")) _graphProps = j["properties"];
+  for (auto nd : getNds()) {
+    uint32_t ndId = static_cast<uint32_t>(ndIds.size());
+    ndIds[nd] = ndId;
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      uint32_t edgId = static_cast<uint32_t>(edgIds.size());
+      edgIds[e] = edgId;
+    }
   }
-  if (j["type"] == "Topology")
-    readFromTopoJson(j["objects"], j["arcs"], useWebMercCoords);
+
+  auto edgId = [&](const LineEdge* e) -> uint32_t {
+    auto i = edgIds.find(e);
+    if (i == edgIds.end())
+      throw std::runtime_error("Connection exception references unknown edge.");
+    return i->second;
+  };
+
+  std::vector<bin::StopRec> stops;
+  std::vector<bin::NdRec> nds;
+  std::vector<bin::ExcRec> excs;
+  std::vector<uint32_t> notServed;
+  std::vector<bin::EdgRec> edgs;
+  std::vector<bin::OccRec> occs;
+  std::vector<uint8_t> geoms;
+
+  for (auto nd : getNds()) {
+    bin::NdRec rec;
+    rec.x = nd->pl().getGeom()->getX();
+    rec.y = nd->pl().getGeom()->getY();
+    rec.comp = nd->pl().getComponent();
+    rec.pad = 0;
+
+    rec.firstStop = static_cast<uint32_t>(stops.size());
+    for (const auto& stop : nd->pl().stops()) {
+      stops.push_back({str(stop.id), str(stop.name), stop.pos.getX(),
+                       stop.pos.getY()});
+    }
+    rec.numStops = static_cast<uint32_t>(stops.size()) - rec.firstStop;
+
+    rec.firstNotServed = static_cast<uint32_t>(notServed.size());
+    for (auto l : nd->pl().getLinesNotServed()) notServed.push_back(line(l));
+    rec.numNotServed =
+        static_cast<uint32_t>(notServed.size()) - rec.firstNotServed;
+
+    // exceptions are indexed in both directions, only write them once
+    rec.firstExc = static_cast<uint32_t>(excs.size());
+    for (const auto& ro : nd->pl().getConnExc()) {
+      for (const auto& exFr : ro.second) {
+        for (auto exTo : exFr.second) {
+          uint32_t a = edgId(exFr.first);
+          uint32_t b = edgId(exTo);
+          if (a > b) continue;
+          excs.push_back({line(ro.first), a, b});
+        }
+      }
+    }
+    rec.numExcs = static_cast<uint32_t>(excs.size()) - rec.firstExc;
+
+    nds.push_back(rec);
+
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+
+      bin::EdgRec erec;
+      erec.from = ndIds[e->getFrom()];
+      erec.to = ndIds[e->getTo()];
+      erec.comp = e->pl().getComponent();
+      erec.flags = e->pl().dontContract() ? bin::EDG_DONT_CONTRACT : 0;
+      erec.pad = 0;
+
+      const auto& geom = e->pl().getPolyline().getLine();
+      erec.geomOff = geoms.size();
+      erec.numPts = static_cast<uint32_t>(geom.size());
+
+      bool fixed = true;
+      for (const auto& p : geom) {
+        if (!bin::isFixed(p.getX()) || !bin::isFixed(p.getY())) {
+          fixed = false;
+          break;
+        }
+      }
+
+      if (fixed) {
+        int64_t x = 0, y = 0;
+        for (const auto& p : geom) {
+          int64_t fx = bin::toFixed(p.getX());
+          int64_t fy = bin::toFixed(p.getY());
+          bin::writeVarInt(fx - x, &geoms);
+          bin::writeVarInt(fy - y, &geoms);
+          x = fx;
+          y = fy;
+        }
+      } else {
+        erec.flags |= bin::EDG_RAW_GEOM;
+        uint64_t x = 0, y = 0;
+        for (const auto& p : geom) {
+          uint64_t bx = bin::toBits(p.getX());
+          uint64_t by = bin::toBits(p.getY());
+          bin::writeVarUInt(bx ^ x, &geoms);
+          bin::writeVarUInt(by ^ y, &geoms);
+          x = bx;
+          y = by;
+        }
+      }
+
+      erec.firstOcc = static_cast<uint32_t>(occs.size());
+      for (const auto& lo : e->pl().getLines()) {
+        occs.push_back({line(lo.line),
+                        lo.direction ? ndIds[lo.direction] : bin::NONE,
+                        style(lo.style)});
+      }
+      erec.numOccs = static_cast<uint32_t>(occs.size()) - erec.firstOcc;
+
+      edgs.push_back(erec);
+    }
+  }
+
+  bin::Header h;
+  memcpy(h.magic, bin::MAGIC, 4);
+  h.version = bin::VERSION;
+  h.bom = bin::BOM;
+  h.props = str(props.is_object() && !props.empty() ? props.dump() : "");
+  h.numStrs = strOffs.size() - 1;
+  h.strBytes = strData.size();
+  h.numLines = lines.size();
+  h.numStyles = styles.size();
+  h.numStops = stops.size();
+  h.numNds = nds.size();
+  h.numEdgs = edgs.size();
+  h.numOccs = occs.size();
+  h.numExcs = excs.size();
+  h.numNotServed = notServed.size();
+  h.geomBytes = geoms.size();
+
+  s->write(reinterpret_cast<const char*>(&h), sizeof(h));
+  bin::writeTbl(s, strOffs);
+  bin::writeTbl(s, lines);
+  bin::writeTbl(s, styles);
+  bin::writeTbl(s, stops);
+  bin::writeTbl(s, nds);
+  bin::writeTbl(s, edgs);
+  bin::writeTbl(s, occs);
+  bin::writeTbl(s, excs);
+  bin::writeTbl(s, notServed);
+  bin::writeTbl(s, strData);
+  bin::writeTbl(s, geoms);
 }
 
 // _____________________________________________________________________________
@@ -441,52 +931,105 @@ const util::geo::DBox& LineGraph::getBBox() const { return _bbox; }
 
 // _____________________________________________________________________________
 void LineGraph::topologizeIsects() {
-  proced.clear();
-  while (getNextIntersection().a) {
-    auto i = getNextIntersection();
-    auto x = addNd({i.bp.p, i.a->pl().getComponent()});
+  // all crossings are collected in one pass over the original edges, and every
+  // edge is then split once at all of its crossings
+
+  // crossings closer than this are merged into a single node, so that three
+  // or more edges crossing at (nearly) the same point share one node
+  double MAXD = 1;
+
+  std::unordered_map<const LineEdge*, std::vector<std::pair<double, LineNode*>>>
+      splits;
+
+  NodeGrid splitNds;
+
+  for (const auto& i : getIntersections()) {
+    LineNode* x = 0;
+    double bestD = MAXD;
+
+    std::set<LineNode*> cands;
+    splitNds.get(i.bp.p, MAXD, &cands);
+    for (auto cand : cands) {
+      double d = util::geo::dist(*cand->pl().getGeom(), i.bp.p);
+      if (d <= bestD) {
+        bestD = d;
+        x = cand;
+      }
+    }
 
-    double pa = i.a->pl().getPolyline().projectOn(i.bp.p).totalPos;
+    if (!x) {
+      x = addNd({i.bp.p, i.a->pl().getComponent()});
+      splitNds.add(i.bp.p, x);
+    }
 
-    auto ba = addEdg(i.b->getFrom(), x, i.b->pl());
-    ba->pl().setPolyline(i.b->pl().getPolyline().getSegment(0, i.bp.totalPos));
+    double pb = i.b->pl().getPolyline().projectOn(i.bp.p).totalPos;
 
-    auto bb = addEdg(x, i.b->getTo(), i.b->pl());
-    bb->pl().setPolyline(i.b->pl().getPolyline().getSegment(i.bp.totalPos, 1));
+    splits[i.a].push_back({i.bp.totalPos, x});
+    splits[i.b].push_back({pb, x});
+  }
 
-    edgeRpl(i.b->getFrom(), i.b, ba);
-    edgeRpl(i.b->getTo(), i.b, bb);
+  // iterate in the original edge order to keep node and edge creation
+  // deterministic
+  std::vector<LineEdge*> edgs;
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      if (splits.count(e)) edgs.push_back(e);
+    }
+  }
 
-    nodeRpl(ba, i.b->getTo(), x);
-    nodeRpl(bb, i.b->getFrom(), x);
+  for (auto e : edgs) {
+    auto& pts = splits[e];
+    std::sort(pts.begin(), pts.end());
 
-    _edgeGrid.add(*ba->pl().getGeom(), ba);
-    _edgeGrid.add(*bb->pl().getGeom(), bb);
+    // an edge may cross several edges at a merged node, split only once there
+    std::set<LineNode*> seen;
+    size_t j = 0;
+    for (const auto& pt : pts) {
+      if (seen.insert(pt.second).second) pts[j++] = pt;
+    }
+    pts.resize(j);
+
+    LineNode* prevNd = e->getFrom();
+    double prevPos = 0;
+    LineEdge* first = 0;
+    LineEdge* last = 0;
+
+    for (size_t i = 0; i <= pts.size(); i++) {
+      LineNode* nd = i < pts.size() ? pts[i].second : e->getTo();
+      double pos = i < pts.size() ? pts[i].first : 1;
+
+      // the crossing points of this edge may be off by up to MAXD from a
+      // merged node, the sub edges start and end exactly at the split nodes
+      auto seg = e->pl().getPolyline().getSegment(prevPos, pos);
+      if (seg.getLine().size() < 2) {
+        seg = PolyLine<double>(*prevNd->pl().getGeom(), *nd->pl().getGeom());
+      } else {
+        if (i > 0) seg.getLine().front() = *prevNd->pl().getGeom();
+        if (i < pts.size()) seg.getLine().back() = *nd->pl().getGeom();
+      }
 
-    auto aa = addEdg(i.a->getFrom(), x, i.a->pl());
-    aa->pl().setPolyline(i.a->pl().getPolyline().getSegment(0, pa));
-    auto ab = addEdg(x, i.a->getTo(), i.a->pl());
-    ab->pl().setPolyline(i.a->pl().getPolyline().getSegment(pa, 1));
+      auto sub = addEdg(prevNd, nd, e->pl());
+      sub->pl().setPolyline(seg);
 
-    edgeRpl(i.a->getFrom(), i.a, aa);
-    edgeRpl(i.a->getTo(), i.a, ab);
+      nodeRpl(sub, e->getTo(), nd);
+      nodeRpl(sub, e->getFrom(), prevNd);
 
-    nodeRpl(aa, i.b->getTo(), x);
-    nodeRpl(ab, i.b->getFrom(), x);
+      _edgeGrid.add(*sub->pl().getGeom(), sub);
 
-    _edgeGrid.remove(aa);
-    _edgeGrid.remove(ab);
+      if (!first) first = sub;
+      last = sub;
+      prevNd = nd;
+      prevPos = pos;
+    }
 
-    _edgeGrid.add(*aa->pl().getGeom(), aa);
-    _edgeGrid.add(*ab->pl().getGeom(), ab);
+    edgeRpl(e->getFrom(), e, first);
+    edgeRpl(e->getTo(), e, last);
 
-    _edgeGrid.remove(i.a);
-    _edgeGrid.remove(i.b);
+    _edgeGrid.remove(e);
 
-    assert(getEdg(i.a->getFrom(), i.a->getTo()));
-    assert(getEdg(i.b->getFrom(), i.b->getTo()));
-    delEdg(i.a->getFrom(), i.a->getTo());
-    delEdg(i.b->getFrom(), i.b->getTo());
+    assert(getEdg(e->getFrom(), e->getTo()));
+    delEdg(e->getFrom(), e->getTo());
   }
 }
 
@@ -500,46 +1043,61 @@ std::set<LineEdge*> LineGraph::getNeighborEdges(const util::geo::DLine& line,
 }
 
 // _____________________________________________________________________________
-ISect LineGraph::getNextIntersection() {
-  for (auto n1 : getNds()) {
-    for (auto e1 : n1->getAdjList()) {
-      if (e1->getFrom() != n1) continue;
-      if (proced.find(e1) != proced.end()) continue;
-
-      std::set<LineEdge*> neighbors;
-      _edgeGrid.getNeighbors(e1, 0, &neighbors);
-
-      for (auto e2 : neighbors) {
-        if (proced.find(e2) != proced.end()) continue;
-        if (e1 != e2) {
-          auto is =
-              e1->pl().getPolyline().getIntersections(e2->pl().getPolyline());
-
-          if (is.size()) {
-            ISect ret;
-            ret.a = e1;
-            ret.b = e2;
-            ret.bp = *is.begin();
-            // if the intersection is near a shared node, ignore
-            auto shrdNd = sharedNode(e1, e2);
-            if (shrdNd &&
-                util::geo::dist(*shrdNd->pl().getGeom(), ret.bp.p) < 100) {
-              continue;
-            }
+std::vector<ISect> LineGraph::getIntersections() const {
+  std::vector<LineEdge*> edgs;
+  std::unordered_map<const LineEdge*, size_t> edgIdx;
 
-            if (ret.bp.totalPos > 0.001 && 1 - ret.bp.totalPos > 0.001) {
-              return ret;
-            }
-          }
+  for (auto n : getNds()) {
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      edgIdx[e] = edgs.size();
+      edgs.push_back(e);
+    }
+  }
+
+  std::vector<std::vector<ISect>> isects(edgs.size());
+
+  // the pair tests only read the graph and the edge grid, every edge pair is
+  // tested exactly once, from the edge with the smaller index
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < edgs.size(); i++) {
+    auto e1 = edgs[i];
+
+    std::set<LineEdge*> neighbors;
+    _edgeGrid.getNeighbors(e1, 0, &neighbors);
+
+    for (auto e2 : neighbors) {
+      // the edge grid may hold edges which are not part of this graph
+      auto j = edgIdx.find(e2);
+      if (j == edgIdx.end()) continue;
+      if (j->second <= i) continue;
+
+      auto is = e1->pl().getPolyline().getIntersections(e2->pl().getPolyline());
+
+      // if the intersection is near a shared node, ignore
+      auto shrdNd = sharedNode(e1, e2);
+
+      for (const auto& bp : is) {
+        if (shrdNd && util::geo::dist(*shrdNd->pl().getGeom(), bp.p) < 100) {
+          continue;
         }
+
+        if (bp.totalPos <= 0.001 || 1 - bp.totalPos <= 0.001) continue;
+
+        double pb = e2->pl().getPolyline().projectOn(bp.p).totalPos;
+        if (pb <= 0.001 || 1 - pb <= 0.001) continue;
+
+        ISect ret;
+        ret.a = e1;
+        ret.b = e2;
+        ret.bp = bp;
+        isects[i].push_back(ret);
       }
-      proced.insert(e1);
     }
   }
 
-  ISect ret;
-  ret.a = 0;
-  ret.b = 0;
+  std::vector<ISect> ret;
+  for (const auto& is : isects) ret.insert(ret.end(), is.begin(), is.end());
   return ret;
 }
 
@@ -1020,7 +1578,7 @@ void LineGraph::contractStrayNds() {
 }
 
 // _____________________________________________________________________________
-void LineGraph::contractEdge(LineEdge* e) {
+LineNode* LineGraph::contractEdge(LineEdge* e) {
   auto n1 = e->getFrom();
   auto n2 = e->getTo();
   auto otherP = n2->pl().getGeom();
@@ -1049,6 +1607,8 @@ void LineGraph::contractEdge(LineEdge* e) {
   }
 
   n->pl().setGeom(newGeom);
+
+  return n;
 }
 
 // _____________________________________________________________________________
@@ -1215,48 +1775,85 @@ std::vector<Partner> LineGraph::getPartners(const LineNode* nd,
 void LineGraph::contractEdges(double d) { contractEdges(d, false); }
 
 // _____________________________________________________________________________
-void LineGraph::contractEdges(double d, bool onlyNonStatConns) {
-  // TODO: the problem here is that contractEdge(e) may delete and replace edges
-  // in the graph, which is why we cannot just build a list of edges eligible
-  // for contraction and iterate over it - we would have to record the changes
-  // made in contractEdge(e) and propagate it back.
+bool LineGraph::contractCand(const LineEdge* e, double d, bool onlyNonStatConns,
+                             size_t* prio) const {
+  auto n1 = e->getFrom();
+  auto n2 = e->getTo();
+
+  if (onlyNonStatConns && (n1->pl().stops().size() || n2->pl().stops().size()))
+    return false;
+
+  if (e->pl().dontContract() || !e->pl().getPolyline().shorterThan(d))
+    return false;
+
+  if (n2->getAdjList().size() > 1 &&
+      (n1->pl().stops().size() == 0 || n1->getAdjList().size() > 1) &&
+      (n1->pl().stops().size() == 0 || n2->pl().stops().size() == 0 ||
+       n1->pl().stops().front().name == n2->pl().stops().front().name)) {
+    // first contract edges with lower number of adjacent nodes,
+    // on ties use shorter edge
+    *prio = n1->getDeg() + n2->getDeg() + e->pl().getPolyline().getLength();
+    return true;
+  }
+
+  return false;
+}
 
-  std::vector<std::pair<size_t, LineEdge*>> cands;
+// _____________________________________________________________________________
+void LineGraph::contractEdges(double d, bool onlyNonStatConns) {
+  // contractEdge(e) deletes and replaces the edges adjacent to the contracted
+  // edge and changes the degrees of the neighboring nodes. Instead of
+  // rescanning the whole graph after each contraction, we only update the
+  // candidates adjacent to these nodes.
+
+  std::set<std::pair<size_t, LineEdge*>> cands;
+  std::unordered_map<const LineEdge*, size_t> prios;
+
+  auto update = [&](LineEdge* e) {
+    if (prios.count(e)) return;
+    size_t prio;
+    if (contractCand(e, d, onlyNonStatConns, &prio)) {
+      cands.insert({prio, e});
+      prios[e] = prio;
+    }
+  };
 
-breakfor:
-  cands.clear();
+  auto remove = [&](LineEdge* e) {
+    auto it = prios.find(e);
+    if (it == prios.end()) return;
+    cands.erase({it->second, e});
+    prios.erase(it);
+  };
 
   for (auto n1 : getNds()) {
     for (auto e : n1->getAdjList()) {
       if (e->getFrom() != n1) continue;
-      if (onlyNonStatConns && (e->getFrom()->pl().stops().size() ||
-                               e->getTo()->pl().stops().size()))
-        continue;
-      if (onlyNonStatConns && (e->getFrom()->pl().stops().size() ||
-                               e->getTo()->pl().stops().size()))
-        continue;
-
-      if (!e->pl().dontContract() && e->pl().getPolyline().shorterThan(d)) {
-        if (e->getOtherNd(n1)->getAdjList().size() > 1 &&
-            (n1->pl().stops().size() == 0 || n1->getAdjList().size() > 1) &&
-            (n1->pl().stops().size() == 0 ||
-             e->getOtherNd(n1)->pl().stops().size() == 0 ||
-             n1->pl().stops().front().name ==
-                 e->getOtherNd(n1)->pl().stops().front().name)) {
-          // first contract edges with lower number of adjacent nodes,
-          // on ties use shorter edge
-          cands.push_back({e->getFrom()->getDeg() + e->getTo()->getDeg() +
-                               e->pl().getPolyline().getLength(),
-                           e});
-        }
-      }
+      update(e);
     }
   }
 
-  std::sort(cands.begin(), cands.end());
-  for (auto e : cands) {
-    contractEdge(e.second);
-    goto breakfor;
+  while (!cands.empty()) {
+    auto e = cands.begin()->second;
+    auto n1 = e->getFrom();
+    auto n2 = e->getTo();
+
+    std::set<LineNode*> nbh{n1, n2};
+    for (auto f : n1->getAdjList()) nbh.insert(f->getOtherNd(n1));
+    for (auto f : n2->getAdjList()) nbh.insert(f->getOtherNd(n2));
+
+    for (auto nd : nbh) {
+      for (auto f : nd->getAdjList()) remove(f);
+    }
+
+    auto merged = contractEdge(e);
+
+    // one of n1, n2 has been deleted
+    if (merged == n1) nbh.erase(n2);
+    if (merged == n2) nbh.erase(n1);
+
+    for (auto nd : nbh) {
+      for (auto f : nd->getAdjList()) update(f);
+    }
   }
 }
 
@@ -1308,14 +1905,75 @@ size_t LineGraph::numConnExcs() const {
 
 // _____________________________________________________________________________
 void LineGraph::extractLines(const nlohmann::json::object_t& props, LineEdge* e,
-                             const std::map<std::string, LineNode*>& idMap) {
+                             const std::map<std::string, LineNode*>& idMap,
+                             const std::vector<const Line*>& lineDict) {
   auto i = props.find("lines");
 
   if (i == props.end()) {
-    extractLine(props, e, idMap);
+    extractLine(props, e, idMap, lineDict);
   } else {
-    for (auto line : i->second) {
-      extractLine(line, e, idMap);
+    for (const auto& line : i->second) {
+      if (line.is_number()) {
+        // compact form, plain reference into the line dictionary
+        size_t idx = line.get<size_t>();
+        if (idx >= lineDict.size()) {
+          LOG(WARN) << "Line reference " << idx << " not in line dictionary.";
+          continue;
+        }
+        e->pl().addLine(lineDict[idx], 0);
+        continue;
+      }
+      extractLine(line.get_ref<const nlohmann::json::object_t&>(), e, idMap,
+                  lineDict);
+    }
+  }
+}
+
+// _____________________________________________________________________________
+bool LineGraph::refsLineDict(const nlohmann::json& props) {
+  if (!props.count("lines") || !props["lines"].is_array()) return false;
+  for (const auto& line : props["lines"]) {
+    if (line.is_number() || (line.is_object() && line.count("line")))
+      return true;
+  }
+  return false;
+}
+
+// _____________________________________________________________________________
+void LineGraph::readLineDict(const nlohmann::json& dict, GeoJsonReadState* st) {
+  st->hasLineDict = true;
+  if (!dict.is_array()) return;
+
+  for (const auto& line : dict) {
+    if (!line.is_object()) {
+      LOG(WARN) << "Invalid line dictionary in graph properties.";
+      st->lineDict.clear();
+      return;
+    }
+  }
+
+  for (const auto& line : dict) {
+    const auto& obj = line.get_ref<const nlohmann::json::object_t&>();
+    std::string id = getLineId(obj);
+
+    const Line* l = getLine(id);
+    if (!l) {
+      l = new Line(id, getLineLabel(obj), getLineColor(obj));
+      addLine(l);
+    }
+
+    st->lineDict.push_back(l);
+  }
+}
+
+// _____________________________________________________________________________
+void LineGraph::addToLineDict(LineDict* dict) const {
+  // lines are taken from the edges, not from _lines, which is empty for
+  // graphs derived from other graphs (for example connected components)
+  for (auto nd : getNds()) {
+    for (auto e : nd->getAdjList()) {
+      if (e->getFrom() != nd) continue;
+      for (const auto& lo : e->pl().getLines()) dict->add(lo.line);
     }
   }
 }
@@ -1451,15 +2109,29 @@ std::string LineGraph::getStationLabel(const nlohmann::json::object_t& line) {
 
 // _____________________________________________________________________________
 void LineGraph::extractLine(const nlohmann::json::object_t& line, LineEdge* e,
-                            const std::map<std::string, LineNode*>& idMap) {
-  std::string id = getLineId(line);
-  std::string color = getLineColor(line);
-  std::string label = getLineLabel(line);
-
-  const Line* l = getLine(id);
-  if (!l) {
-    l = new Line(id, label, color);
-    addLine(l);
+                            const std::map<std::string, LineNode*>& idMap,
+                            const std::vector<const Line*>& lineDict) {
+  const Line* l = 0;
+
+  auto ref = line.find("line");
+  if (ref != line.end() && ref->second.is_number()) {
+    // compact form, reference into the line dictionary
+    size_t idx = ref->second.get<size_t>();
+    if (idx >= lineDict.size()) {
+      LOG(WARN) << "Line reference " << idx << " not in line dictionary.";
+      return;
+    }
+    l = lineDict[idx];
+  } else {
+    std::string id = getLineId(line);
+    std::string color = getLineColor(line);
+    std::string label = getLineLabel(line);
+
+    l = getLine(id);
+    if (!l) {
+      l = new Line(id, label, color);
+      addLine(l);
+    }
   }
 
   LineNode* dir = 0;
@@ -1474,7 +2146,7 @@ void LineGraph::extractLine(const nlohmann::json::object_t& line, LineEdge* e,
     if (line.count("style")) ls.setCss(line.at("style"));
     if (line.count("outline-style")) ls.setOutlineCss(line.at("outline-style"));
 
-    e->pl().addLine(l, dir, ls);
+    e->pl().addLine(l, dir, shared::style::LineStyle::intern(ls));
   } else {
     e->pl().addLine(l, dir);
   }
@@ -1489,50 +2161,121 @@ std::vector<LineGraph> LineGraph::distConnectedComponents(double d,
 // _____________________________________________________________________________
 std::vector<LineGraph> LineGraph::distConnectedComponents(double d, bool write,
                                                           size_t* offset) {
-  std::vector<LineGraph> ret;
+  return distConnectedComponents(d, write, offset, false);
+}
 
-  size_t idOffset = 0;
+// _____________________________________________________________________________
+std::vector<std::vector<LineNode*>> LineGraph::distComponents(double d) const {
+  // union-find over the edges and over all node pairs within distance d
+  std::unordered_map<const LineNode*, size_t> idx;
+  std::vector<LineNode*> nds;
+  for (auto nd : getNds()) {
+    idx[nd] = nds.size();
+    nds.push_back(nd);
+  }
 
-  if (offset) idOffset = *offset;
+  std::vector<size_t> parent(nds.size());
+  std::vector<size_t> size(nds.size(), 1);
+  for (size_t i = 0; i < parent.size(); i++) parent[i] = i;
 
-  // first pass, collect components
-  const auto& origComps = Algorithm::connectedComponents(*this);
-  std::unordered_map<LineNode*, size_t> ndToComp;
-  for (size_t comp = 0; comp < origComps.size(); comp++) {
-    for (auto nd : origComps[comp]) {
-      ndToComp[nd] = comp;
+  auto find = [&parent](size_t i) -> size_t {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  auto unite = [&](size_t a, size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (size[a] < size[b]) std::swap(a, b);
+    parent[b] = a;
+    size[a] += size[b];
+  };
+
+  for (size_t i = 0; i < nds.size(); i++) {
+    for (auto e : nds[i]->getAdjList()) {
+      if (e->getFrom() != nds[i]) continue;
+      unite(i, idx[e->getTo()]);
     }
-  }
-
-  std::vector<LineEdge*> addedEdgs;
 
-  for (auto nd : getNds()) {
-    // connect each node with nodes within distance
     std::set<LineNode*> cands;
-    _nodeGrid.get(*nd->pl().getGeom(), d, &cands);
+    _nodeGrid.get(*nds[i]->pl().getGeom(), d, &cands);
 
     for (auto cand : cands) {
-      if (cand != nd && !getEdg(nd, cand) && !getEdg(cand, nd) &&
-          ndToComp[nd] != ndToComp[cand] &&
-          util::geo::dist(*nd->pl().getGeom(), *cand->pl().getGeom()) <= d) {
-        addedEdgs.push_back(addEdg(nd, cand));
+      if (cand != nds[i] &&
+          util::geo::dist(*nds[i]->pl().getGeom(), *cand->pl().getGeom()) <=
+              d) {
+        unite(i, idx[cand]);
       }
     }
   }
 
-  const auto& geoComps = Algorithm::connectedComponents(*this);
-
-  // delete the newly added edges
-  for (auto e : addedEdgs) {
-    _edgeGrid.remove(e);
-    delEdg(e->getFrom(), e->getTo());
+  // components are numbered in order of their first node
+  std::vector<std::vector<LineNode*>> ret;
+  std::vector<size_t> compIdx(nds.size(), std::numeric_limits<size_t>::max());
+  for (size_t i = 0; i < nds.size(); i++) {
+    size_t root = find(i);
+    if (compIdx[root] == std::numeric_limits<size_t>::max()) {
+      compIdx[root] = ret.size();
+      ret.push_back({});
+    }
+    ret[compIdx[root]].push_back(nds[i]);
   }
 
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<LineGraph> LineGraph::distConnectedComponents(double d, bool write,
+                                                          size_t* offset,
+                                                          bool move) {
+  std::vector<LineGraph> ret;
+
+  size_t idOffset = 0;
+
+  if (offset) idOffset = *offset;
+
+  const auto& geoComps = distComponents(d);
+
   ret.resize(geoComps.size());
 
   for (size_t comp = 0; comp < geoComps.size(); comp++) {
     auto* tg = &ret[comp];
 
+    if (move) {
+      // edges without lines are dropped, as in the copy below
+      std::vector<LineEdge*> empty;
+
+      for (auto nd : geoComps[comp]) {
+        if (write) nd->pl().setComponent(idOffset + comp);
+        tg->_nodes.insert(nd);
+        tg->expandBBox(*nd->pl().getGeom());
+
+        for (auto edg : nd->getAdjList()) {
+          if (edg->getFrom() != nd) continue;
+          if (write) edg->pl().setComponent(idOffset + comp);
+          if (edg->pl().getLines().size() == 0) {
+            empty.push_back(edg);
+            continue;
+          }
+
+          tg->expandBBox(edg->pl().getGeom()->front());
+          tg->expandBBox(edg->pl().getGeom()->back());
+        }
+      }
+
+      for (auto edg : empty) {
+        edgeDel(edg->getFrom(), edg);
+        edgeDel(edg->getTo(), edg);
+        tg->delEdg(edg->getFrom(), edg->getTo());
+      }
+
+      continue;
+    }
+
     std::unordered_map<LineNode*, LineNode*> nm;
     std::unordered_map<LineEdge*, LineEdge*> em;
 
@@ -1564,6 +2307,14 @@ std::vector<LineGraph> LineGraph::distConnectedComponents(double d, bool write,
     }
   }
 
+  if (move) {
+    // the nodes are now owned by the component graphs
+    _nodes.clear();
+    _nodeGrid = NodeGrid();
+    _edgeGrid = EdgeGrid();
+    _bbox = util::geo::DBox();
+  }
+
   if (offset) *offset = idOffset + geoComps.size() + 1;
 
   return ret;
@@ -1648,3 +2399,31 @@ void LineGraph::removeDeg1Nodes() {
     delNd(n);
   }
 }
+
+// _____________________________________________________________________________
+void LineGraph::absorb(LineGraph* g) {
+  for (auto n : g->getNds()) {
+    _nodes.insert(n);
+    _nodeGrid.add(*n->pl().getGeom(), n);
+    expandBBox(*n->pl().getGeom());
+
+    for (auto e : n->getAdjList()) {
+      if (e->getFrom() != n) continue;
+      _edgeGrid.add(*e->pl().getGeom(), e);
+      expandBBox(e->pl().getGeom()->front());
+      expandBBox(e->pl().getGeom()->back());
+
+      // component graphs do not carry their own line index
+      for (const auto& lo : e->pl().getLines()) addLine(lo.line);
+    }
+  }
+
+  for (const auto& l : g->_lines) addLine(l.second);
+
+  // the nodes are now owned by this graph
+  g->_nodes.clear();
+  g->_lines.clear();
+  g->_nodeGrid = NodeGrid();
+  g->_edgeGrid = EdgeGrid();
+  g->_bbox = util::geo::DBox();
+}
@@ -6,13 +6,16 @@
 #define SHARED_LINEGRAPH_LINEGRAPH_H_
 
 #include "3rdparty/json.hpp"
+#include "shared/linegraph/BinFormat.h"
 #include "shared/linegraph/EdgeOrdering.h"
 #include "shared/linegraph/LineEdgePL.h"
 #include "shared/linegraph/LineNodePL.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
+#include "util/geo/PolyLine.h"
 #include "util/geo/RTree.h"
 #include "util/graph/UndirGraph.h"
+#include "util/json/Writer.h"
 
 namespace shared {
 namespace linegraph {
@@ -27,6 +30,7 @@ typedef util::geo::RTree<LineEdge*, util::geo::Line, double> EdgeGrid;
 
 struct ISect {
   LineEdge *a, *b;
+  // intersection point, position is on a
   util::geo::LinePoint<double> bp;
 };
 
@@ -47,7 +51,6 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   LineGraph(LineGraph&& other) {
     _bbox = other._bbox;
-    proced = other.proced;
     _lines = other._lines;
     _nodeGrid = std::move(other._nodeGrid);
     _edgeGrid = std::move(other._edgeGrid);
@@ -62,7 +65,6 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   LineGraph& operator=(LineGraph&& other) {
     _bbox = other._bbox;
-    proced = other.proced;
     _lines = other._lines;
     _nodeGrid = std::move(other._nodeGrid);
     _edgeGrid = std::move(other._edgeGrid);
@@ -77,15 +79,30 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   }
 
   virtual void readFromJson(std::istream* s);
-  virtual void readFromGeoJson(nlohmann::json::array_t);
+  virtual void readFromGeoJson(const nlohmann::json::array_t& features);
   virtual void readFromTopoJson(nlohmann::json::array_t objects,
                                 nlohmann::json::array_t arc);
 
   virtual void readFromJson(std::istream* s, bool useWebMerc);
-  virtual void readFromGeoJson(nlohmann::json::array_t, bool useWebMerc);
+  virtual void readFromGeoJson(const nlohmann::json::array_t& features,
+                               bool useWebMerc);
   virtual void readFromTopoJson(nlohmann::json::array_t objects,
                                 nlohmann::json::array_t arc, bool useWebMerc);
   virtual void readFromDot(std::istream* s);
+  virtual void readFromBin(std::istream* s);
+  virtual void readFromBin(const std::vector<bin::Section>& secs);
+
+  // read only the next section of a binary graph stream, returns false if
+  // the stream holds no further section
+  bool readBinSection(std::istream* s);
+
+  // read only the next component chunk written by ComponentWriter, either a
+  // binary graph section or a GeoJSON feature collection, returns false if
+  // the stream holds no further chunk
+  bool readChunk(std::istream* s);
+
+  void writeToBin(std::ostream* s, const nlohmann::json& props) const;
+  void writeToBin(std::ostream* s, const util::json::Dict& props) const;
 
   void smooth(double smooth);
 
@@ -158,7 +175,7 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
 
   void contractEdges(double d);
   void contractEdges(double d, bool onlyNonStatConns);
-  void contractEdge(LineEdge* e);
+  LineNode* contractEdge(LineEdge* e);
 
   double searchSpaceSize() const;
 
@@ -170,22 +187,99 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   std::vector<LineGraph> distConnectedComponents(double d, bool write,
                                                  size_t* offset);
 
+  // if move is set, the nodes and edges are moved into the component graphs
+  // instead of being copied, and this graph is left empty
+  std::vector<LineGraph> distConnectedComponents(double d, bool write,
+                                                 size_t* offset, bool move);
+
   void fillMissingColors();
 
   void removeDeg1Nodes();
 
+  // add all lines occurring on the edges of this graph to dict
+  void addToLineDict(LineDict* dict) const;
+
+  // move all nodes and edges of g into this graph, g is left empty
+  void absorb(LineGraph* g);
+
   const nlohmann::json::object_t& getGraphProps() const { return _graphProps; }
 
  private:
   util::geo::Box<double> _bbox;
 
-  ISect getNextIntersection();
+  std::vector<ISect> getIntersections() const;
+
+  // nodes of the components formed by the edges and by node pairs within
+  // distance d
+  std::vector<std::vector<LineNode*>> distComponents(double d) const;
+
+  // a GeoJSON feature together with the data which can be derived from it
+  // without access to the graph, prepared in parallel
+  struct GeoJsonFeature {
+    nlohmann::json json;
+    bool isNd = false;
+    bool isEdg = false;
+
+    // node id, or the ids of the edge end nodes. End node ids derived from
+    // the edge geometry are marked as implicit
+    std::string id, from, to;
+    bool implFrom = false, implTo = false;
+
+    util::geo::DPoint point;
+    util::geo::PolyLine<double> pl;
+    util::geo::DBox box;
+    size_t component = std::numeric_limits<uint32_t>::max();
+  };
+
+  // bookkeeping while reading GeoJSON features
+  struct GeoJsonReadState {
+    std::map<std::string, LineNode*> idMap;
+
+    // nodes implicitly created by edge end points
+    std::set<LineNode*> implNds;
+
+    // edges referencing nodes which have not been read yet
+    std::vector<GeoJsonFeature> pendingEdgs;
+
+    // node features carrying line exceptions, read after all edges
+    std::vector<nlohmann::json> pendingExcs;
+
+    // line dictionary from the FeatureCollection properties, for edges
+    // referencing lines by index
+    std::vector<const Line*> lineDict;
+    bool hasLineDict = false;
+  };
+
+  std::string getGeoJsonNdId(nlohmann::json& feature, bool webMercCoords) const;
+  void prepGeoJsonFeature(bool webMercCoords, GeoJsonFeature* f) const;
+  void readGeoJsonBatch(std::vector<GeoJsonFeature>* batch, bool webMercCoords,
+                        GeoJsonReadState* st);
+  void readGeoJsonNd(GeoJsonFeature* f, GeoJsonReadState* st);
+  bool readGeoJsonEdg(GeoJsonFeature* f, bool force, GeoJsonReadState* st);
+  void readGeoJsonExcs(nlohmann::json& feature, bool webMercCoords,
+                       GeoJsonReadState* st);
+  void readLineDict(const nlohmann::json& dict, GeoJsonReadState* st);
+
+  // read the next JSON document of s into this graph, geoJson is set if it
+  // was a feature collection. Returns false if s holds no further document.
+  bool readJsonDoc(std::istream* s, bool useWebMercCoords, bool* geoJson);
+  static bool refsLineDict(const nlohmann::json& props);
+
+  // read a single binary graph section into buf, which must outlive the
+  // returned section
+  static bin::Section readBinSectionBuf(std::istream* s,
+                                        std::vector<uint64_t>* buf);
 
   void buildGrids();
+
+  bool contractCand(const LineEdge* e, double d, bool onlyNonStatConns,
+                    size_t* prio) const;
   void extractLines(const nlohmann::json::object_t& pars, LineEdge* e,
-                    const std::map<std::string, LineNode*>& idMap);
+                    const std::map<std::string, LineNode*>& idMap,
+                    const std::vector<const Line*>& lineDict);
   void extractLine(const nlohmann::json::object_t& pars, LineEdge* e,
-                   const std::map<std::string, LineNode*>& idMap);
+                   const std::map<std::string, LineNode*>& idMap,
+                   const std::vector<const Line*>& lineDict);
 
   std::string getLineColor(const nlohmann::json::object_t& line);
   std::string getLineLabel(const nlohmann::json::object_t& line);
@@ -194,8 +288,6 @@ class LineGraph : public util::graph::UndirGraph<LineNodePL, LineEdgePL> {
   std::string getStationLabel(const nlohmann::json::object_t& props);
   std::string getStationId(const nlohmann::json::object_t& props);
 
-  // TODO: remove this
-  std::set<LineEdge*> proced;
   std::map<std::string, const Line*> _lines;
 
   NodeGrid _nodeGrid;
@@ -6,6 +6,7 @@
 #include "shared/linegraph/LineNodePL.h"
 #include "shared/linegraph/NodeFront.h"
 
+using shared::linegraph::GeoJsonWriter;
 using shared::linegraph::LineNodePL;
 using shared::linegraph::NodeFront;
 using shared::linegraph::Station;
@@ -99,6 +100,51 @@ util::json::Dict LineNodePL::getAttrs() const {
   return obj;
 }
 
+// _____________________________________________________________________________
+void LineNodePL::writeAttrs(GeoJsonWriter* w) const {
+  if (_is.size() > 0) {
+    w->keyVal("station_id", _is.begin()->id);
+    w->keyVal("station_label", _is.begin()->name);
+  }
+
+  bool hasExcs = false;
+
+  for (const auto& ro : _connEx) {
+    for (const auto& exFr : ro.second) {
+      for (const auto* exTo : exFr.second) {
+        if (exFr.first == exTo) continue;
+        auto shrd = LineGraph::sharedNode(exFr.first, exTo);
+        if (!shrd) continue;
+
+        if (!hasExcs) {
+          w->key("excluded_conn");
+          w->arr();
+          hasExcs = true;
+        }
+
+        w->obj();
+        w->keyVal("line", ro.first->id());
+        w->key("node_from");
+        w->valId(exFr.first->getOtherNd(shrd));
+        w->key("node_to");
+        w->valId(exTo->getOtherNd(shrd));
+        w->close();
+      }
+    }
+  }
+
+  if (hasExcs) w->close();
+
+  w->component(_comp);
+
+  if (_notServed.size()) {
+    w->key("not_serving");
+    w->arr();
+    for (const auto& no : _notServed) w->val(no->id());
+    w->close();
+  }
+}
+
 // _____________________________________________________________________________
 void LineNodePL::addStop(const Station& i) { _is.push_back(i); }
 
@@ -68,6 +68,7 @@ class LineNodePL : util::geograph::GeoNodePL<double> {
   const util::geo::Point<double>* getGeom() const;
   void setGeom(const util::geo::Point<double>& p);
   util::json::Dict getAttrs() const;
+  void writeAttrs(GeoJsonWriter* w) const;
 
   void addStop(const Station& i);
   const std::vector<Station>& stops() const;
@@ -93,7 +94,7 @@ class LineNodePL : util::geograph::GeoNodePL<double> {
   bool lineServed(const Line* r) const;
   void setNotServed(const NotServedLines& notServed);
 
-  const NotServedLines& getLinesNotServed() { return _notServed; }
+  const NotServedLines& getLinesNotServed() const { return _notServed; }
 
   void clearConnExc();
 
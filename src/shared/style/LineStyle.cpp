@@ -2,6 +2,9 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <mutex>
+#include <set>
+
 #include "shared/style/LineStyle.h"
 
 using shared::style::LineStyle;
@@ -25,3 +28,13 @@ void LineStyle::setCss(const std::string& css) {
 const std::string& LineStyle::getCss() const {
   return _css;
 }
+
+// _____________________________________________________________________________
+const LineStyle* LineStyle::intern(const LineStyle& ls) {
+  // styles are few and long-living, we never free them
+  static std::mutex m;
+  static std::set<LineStyle> styles;
+
+  std::lock_guard<std::mutex> lock(m);
+  return &*styles.insert(ls).first;
+}
@@ -21,9 +21,18 @@ class LineStyle {
   void setCss(const std::string& css);
   const std::string& getCss() const;
 
+  // returns a pointer to a process-wide unique copy of ls, stable for the
+  // lifetime of the program
+  static const LineStyle* intern(const LineStyle& ls);
+
  private:
   std::string _css, _oCss;
 };
+
+inline bool operator<(const LineStyle& a, const LineStyle& b) {
+  if (a.getCss() != b.getCss()) return a.getCss() < b.getCss();
+  return a.getOutlineCss() < b.getOutlineCss();
+}
 }
 }
 
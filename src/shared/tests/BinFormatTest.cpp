@@ -0,0 +1,267 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "shared/linegraph/BinFormat.h"
+#include "shared/linegraph/BinGraphView.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/tests/BinFormatTest.h"
+#include "util/Misc.h"
+
+using shared::linegraph::BinGraphView;
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using shared::linegraph::Station;
+using util::approx;
+
+// _____________________________________________________________________________
+void BinFormatTest::run() {
+  {
+    //  a -> b -> c
+    //       |
+    //       d
+    LineGraph g;
+
+    auto a = g.addNd({{0.0, 0.0}});
+    auto b = g.addNd({{100.5, 0.0}});
+    auto c = g.addNd({{200.0, 0.0}});
+    auto d = g.addNd({{100.5, -100.25}});
+
+    b->pl().addStop(Station("1", "Hauptbahnhof", {100.5, 0.0}));
+
+    util::geo::DLine abGeom{{0.0, 0.0}, {50.0, 1.0}, {100.5, 0.0}};
+    auto ab = g.addEdg(a, b, util::geo::PolyLine<double>(abGeom));
+    auto bc = g.addEdg(b, c, {{{100.5, 0.0}, {200.0, 0.0}}});
+    auto bd = g.addEdg(b, d, {{{100.5, 0.0}, {100.5, -100.25}}});
+
+    Line l1("1", "1", "red");
+    Line l2("2", "2", "blue");
+    g.addLine(&l1);
+    g.addLine(&l2);
+
+    shared::style::LineStyle ls;
+    ls.setCss("stroke-dasharray:4");
+
+    ab->pl().addLine(&l2, b, shared::style::LineStyle::intern(ls));
+    ab->pl().addLine(&l1, 0);
+    bc->pl().addLine(&l1, 0);
+    bc->pl().addLine(&l2, 0);
+    bd->pl().addLine(&l1, d);
+
+    b->pl().addConnExc(&l2, ab, bc);
+    d->pl().addLineNotServed(&l1);
+
+    ab->pl().setComponent(3);
+    bd->pl().setDontContract(true);
+
+    nlohmann::json props;
+    props["statistics"]["num_nds"] = 4;
+
+    char tmpl[] = "/tmp/loom-bin-test-XXXXXX";
+    int fd = mkstemp(tmpl);
+    TEST(fd != -1);
+    close(fd);
+
+    std::string fname = tmpl;
+    {
+      std::ofstream f(fname, std::ios::binary);
+      g.writeToBin(&f, props);
+    }
+
+    BinGraphView view;
+    view.open(fname);
+    TEST(view.getSections().size(), ==, 1);
+    TEST(view.numNds(), ==, 4);
+    TEST(view.numEdgs(), ==, 3);
+
+    const auto& sec = view.getSections().front();
+    for (size_t i = 0; i < view.numEdgs(); i++) {
+      if (BinGraphView::edg(sec, i).numPts != 3) continue;
+      TEST(BinGraphView::edgGeom(sec, i).getLine()[1].getX(), ==, approx(50));
+      auto occ = BinGraphView::lineOccsBegin(sec, i);
+      TEST(BinGraphView::lineColor(sec, occ->line), ==, "blue");
+      TEST(BinGraphView::lineOccsEnd(sec, i) - occ, ==, 2);
+    }
+
+    bool outOfRange = false;
+    try {
+      BinGraphView::nd(sec, 4);
+    } catch (const std::out_of_range& e) {
+      outOfRange = true;
+    }
+    TEST(outOfRange);
+
+    LineGraph m;
+    view.materialize(&m);
+    TEST(m.numNds(), ==, 4);
+    TEST(m.numEdgs(), ==, 3);
+    view.close();
+
+    // a descriptor is mapped starting at its current offset
+    {
+      std::ofstream f(fname, std::ios::binary);
+      f.write("12345678", 8);
+      g.writeToBin(&f, props);
+    }
+
+    fd = ::open(fname.c_str(), O_RDONLY);
+    TEST(fd != -1);
+    TEST(!view.open(fd));
+    TEST(lseek(fd, 8, SEEK_SET), ==, 8);
+    TEST(view.open(fd));
+    TEST(view.numNds(), ==, 4);
+    TEST(view.numEdgs(), ==, 3);
+    ::close(fd);
+    view.close();
+
+    std::stringstream ss;
+    g.writeToBin(&ss, props);
+
+    // two graph sections in one stream are merged
+    g.writeToBin(&ss, nlohmann::json());
+
+    LineGraph h;
+    h.readFromJson(&ss, false);
+
+    TEST(h.numNds(), ==, 8);
+    TEST(h.numEdgs(), ==, 6);
+    TEST(h.numLines(), ==, 2);
+    TEST(h.numConnExcs(), ==, 2);
+    TEST(h.getGraphProps().at("statistics")["num_nds"], ==, 4);
+
+    size_t stations = 0;
+    size_t notServed = 0;
+    for (auto nd : h.getNds()) {
+      stations += nd->pl().stops().size();
+      notServed += nd->pl().getLinesNotServed().size();
+      if (nd->pl().stops().size()) {
+        TEST(nd->pl().stops().front().name, ==, "Hauptbahnhof");
+        TEST(nd->pl().getGeom()->getX(), ==, approx(100.5));
+      }
+    }
+    TEST(stations, ==, 2);
+    TEST(notServed, ==, 2);
+
+    for (auto nd : h.getNds()) {
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        if (e->pl().getPolyline().getLine().size() == 3) {
+          // line order and directions are preserved
+          TEST(e->pl().getLines().size(), ==, 2);
+          TEST(e->pl().lineOccAtPos(0).line->id(), ==, "2");
+          TEST(e->pl().lineOccAtPos(0).direction, ==, e->getTo());
+          TEST(e->pl().lineOccAtPos(0).style->getCss(), ==,
+               "stroke-dasharray:4");
+          TEST(e->pl().lineOccAtPos(1).line->id(), ==, "1");
+          TEST(e->pl().lineOccAtPos(1).style == 0);
+          TEST(e->pl().getComponent(), ==, 3);
+          TEST(e->pl().getPolyline().getLine()[1].getY(), ==, approx(1));
+        }
+        if (e->pl().dontContract()) {
+          TEST(e->pl().lineOccAtPos(0).direction, ==, e->getTo());
+          TEST(e->getTo()->pl().getGeom()->getY(), ==, approx(-100.25));
+        }
+      }
+    }
+
+    // sections with indices out of range are rejected
+    std::stringstream bad;
+    g.writeToBin(&bad, nlohmann::json());
+    std::string data = bad.str();
+
+    std::vector<uint64_t> buf(data.size() / sizeof(uint64_t));
+    memcpy(buf.data(), data.data(), buf.size() * sizeof(uint64_t));
+    auto badSec = shared::linegraph::bin::mapSection(
+        reinterpret_cast<const char*>(buf.data()));
+    const_cast<shared::linegraph::bin::EdgRec*>(badSec.edgs)->to = 1000;
+
+    std::stringstream badIn(std::string(
+        reinterpret_cast<const char*>(buf.data()), data.size()));
+    LineGraph bg;
+    bool thrown = false;
+    try {
+      bg.readFromJson(&badIn, false);
+    } catch (const std::runtime_error& e) {
+      thrown = true;
+    }
+    TEST(thrown);
+    TEST(bg.numNds(), ==, 0);
+
+    // ... and already on mapping them
+    {
+      std::ofstream f(fname, std::ios::binary);
+      f.write(reinterpret_cast<const char*>(buf.data()), data.size());
+    }
+
+    thrown = false;
+    try {
+      view.open(fname);
+    } catch (const std::runtime_error& e) {
+      thrown = true;
+    }
+    TEST(thrown);
+    view.close();
+    std::remove(fname.c_str());
+  }
+  {
+    // edge geometries survive a round trip bit-exactly, both for coordinates
+    // representable as fixed point values and for arbitrary doubles
+    LineGraph g;
+
+    util::geo::DLine fixedGeom{{0.0, 0.0}, {50.125, -1.5}, {100.5, 0.0}};
+    util::geo::DLine rawGeom{{100.5, 0.0},
+                             {1.0 / 3.0, 2.0 / 3.0},
+                             {0.1 + 0.2, 1e6 + 0.1},
+                             {-872404.123456789, 6107467.000001}};
+
+    auto a = g.addNd({fixedGeom.front()});
+    auto b = g.addNd({fixedGeom.back()});
+    auto c = g.addNd({rawGeom.back()});
+
+    auto ab = g.addEdg(a, b, util::geo::PolyLine<double>(fixedGeom));
+    auto bc = g.addEdg(b, c, util::geo::PolyLine<double>(rawGeom));
+
+    Line l1("1", "1", "red");
+    g.addLine(&l1);
+    ab->pl().addLine(&l1, 0);
+    bc->pl().addLine(&l1, 0);
+
+    std::stringstream ss;
+    g.writeToBin(&ss, nlohmann::json());
+
+    LineGraph h;
+    h.readFromJson(&ss, false);
+
+    TEST(h.numEdgs(), ==, 2);
+
+    size_t checked = 0;
+    for (auto nd : h.getNds()) {
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        const auto& got = e->pl().getPolyline().getLine();
+        const auto& exp = got.size() == fixedGeom.size() ? fixedGeom : rawGeom;
+        TEST(got.size(), ==, exp.size());
+        for (size_t i = 0; i < got.size(); i++) {
+          double gx = got[i].getX(), gy = got[i].getY();
+          double ex = exp[i].getX(), ey = exp[i].getY();
+          TEST(memcmp(&gx, &ex, sizeof(double)), ==, 0);
+          TEST(memcmp(&gy, &ey, sizeof(double)), ==, 0);
+        }
+
+        checked++;
+      }
+    }
+    TEST(checked, ==, 2);
+  }
+}
@@ -0,0 +1,223 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <string>
+#include "shared/linegraph/ComponentWriter.h"
+#include "shared/linegraph/GeoJsonWriter.h"
+#include "shared/linegraph/LineDict.h"
+#include "shared/linegraph/LineGraph.h"
+#include "shared/tests/GeoJsonTest.h"
+#include "util/Misc.h"
+
+using shared::linegraph::ComponentWriter;
+using shared::linegraph::GeoJsonWriter;
+using shared::linegraph::LineDict;
+using shared::linegraph::LineGraph;
+
+// _____________________________________________________________________________
+void GeoJsonTest::run() {
+  {
+    // compact line references, with the dictionary after the features, and a
+    // verbose line on the same edge
+    std::stringstream ss;
+    ss << "{\"type\":\"FeatureCollection\",\"features\":["
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+          "\"coordinates\":[[0,0],[100,0]]},\"properties\":{\"from\":\"a\","
+          "\"to\":\"b\",\"lines\":[1,{\"line\":0,\"direction\":\"b\"},"
+          "{\"id\":\"3\",\"label\":\"3\",\"color\":\"00ff00\"}]}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[0,0]},\"properties\":{\"id\":\"a\"}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[100,0]},\"properties\":{\"id\":\"b\","
+          "\"station_label\":\"B\"}}],"
+          "\"properties\":{\"lines\":["
+          "{\"id\":\"1\",\"label\":\"1\",\"color\":\"ff0000\"},"
+          "{\"id\":\"2\",\"label\":\"2\",\"color\":\"0000ff\"}]}}";
+
+    LineGraph g;
+    g.readFromJson(&ss, true);
+
+    TEST(g.numNds(), ==, 2);
+    TEST(g.numEdgs(), ==, 1);
+    TEST(g.numLines(), ==, 3);
+    TEST(g.getGraphProps().count("lines"), ==, 0);
+
+    for (auto nd : g.getNds()) {
+      for (auto e : nd->getAdjList()) {
+        if (e->getFrom() != nd) continue;
+        TEST(e->pl().getLines().size(), ==, 3);
+        TEST(e->pl().lineOccAtPos(0).line->color(), ==, "0000ff");
+        TEST(e->pl().lineOccAtPos(0).direction == 0);
+        TEST(e->pl().lineOccAtPos(1).line->id(), ==, "1");
+        TEST(e->pl().lineOccAtPos(1).direction, ==, e->getTo());
+        TEST(e->pl().lineOccAtPos(2).line->id(), ==, "3");
+        TEST(e->getTo()->pl().stops().size(), ==, 1);
+      }
+    }
+  }
+
+  {
+    // round trip through the direct writer, verbose and compact
+    std::stringstream ss;
+    ss << "{\"type\":\"FeatureCollection\",\"features\":["
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+          "\"coordinates\":[[7.5,47.5],[7.6,47.55]]},\"properties\":{"
+          "\"from\":\"a\",\"to\":\"b\",\"lines\":[{\"id\":\"1\","
+          "\"label\":\"1 \\\"x\\\"\",\"color\":\"ff0000\"}]}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[7.5,47.5]},\"properties\":{\"id\":\"a\","
+          "\"station_label\":\"A\"}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[7.6,47.55]},\"properties\":{\"id\":\"b\"}}]}";
+
+    LineGraph g;
+    g.readFromJson(&ss);
+
+    for (size_t compact = 0; compact < 2; compact++) {
+      LineDict dict;
+      util::json::Dict props;
+      if (compact) {
+        g.addToLineDict(&dict);
+        props["lines"] = dict.toJson();
+      }
+
+      std::stringstream out;
+      {
+        GeoJsonWriter w(&out, props);
+        if (compact) w.setLineDict(&dict);
+        w.printLatLng(g);
+      }
+
+      LineGraph h;
+      h.readFromJson(&out);
+
+      TEST(h.numNds(), ==, 2);
+      TEST(h.numEdgs(), ==, 1);
+      TEST(h.numLines(), ==, 1);
+      TEST(h.getLine("1")->label(), ==, "1 \"x\"");
+      TEST(util::geo::dist(g.getBBox().getLowerLeft(),
+                           h.getBBox().getLowerLeft()),
+           <, 0.01);
+      TEST(util::geo::dist(g.getBBox().getUpperRight(),
+                           h.getBBox().getUpperRight()),
+           <, 0.01);
+    }
+  }
+  {
+    // compact output of connected components, which share the lines of the
+    // original graph but have no own line list
+    std::stringstream ss;
+    ss << "{\"type\":\"FeatureCollection\",\"features\":["
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+          "\"coordinates\":[[0,0],[100,0]]},\"properties\":{\"from\":\"a\","
+          "\"to\":\"b\",\"lines\":[{\"id\":\"1\",\"color\":\"ff0000\"},"
+          "{\"id\":\"2\",\"color\":\"0000ff\"}]}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\","
+          "\"coordinates\":[[5000,0],[5100,0]]},\"properties\":{\"from\":"
+          "\"c\",\"to\":\"d\",\"lines\":[{\"id\":\"3\","
+          "\"color\":\"00ff00\"}]}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[0,0]},\"properties\":{\"id\":\"a\"}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[100,0]},\"properties\":{\"id\":\"b\"}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[5000,0]},\"properties\":{\"id\":\"c\"}},"
+          "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\","
+          "\"coordinates\":[5100,0]},\"properties\":{\"id\":\"d\"}}]}";
+
+    LineGraph g;
+    g.readFromJson(&ss, true);
+
+    for (size_t move = 0; move < 2; move++) {
+      auto comps = g.distConnectedComponents(1000, false, 0, move);
+      TEST(comps.size(), ==, 2);
+
+      size_t numLines = 0;
+
+      for (const auto& comp : comps) {
+        TEST(comp.numLines(), ==, 0);
+
+        LineDict dict;
+        comp.addToLineDict(&dict);
+
+        util::json::Dict props;
+        props["lines"] = dict.toJson();
+
+        std::stringstream out;
+        {
+          GeoJsonWriter w(&out, props);
+          w.setLineDict(&dict);
+          w.printLatLng(comp);
+        }
+
+        LineGraph h;
+        h.readFromJson(&out, true);
+
+        TEST(h.numEdgs(), ==, 1);
+        TEST(h.numLines(), ==, dict.size());
+        numLines += h.numLines();
+      }
+
+      TEST(numLines, ==, 3);
+
+      // the same components streamed as self-contained chunks
+      std::stringstream out;
+      {
+        ComponentWriter w(&out, "json-compact");
+        for (const auto& comp : comps) w.write(comp);
+        util::json::Dict props;
+        props["test"] = "a";
+        w.close(props);
+      }
+
+      // one chunk per line, each with its own line dictionary
+      std::string chunks = out.str();
+      TEST(std::count(chunks.begin(), chunks.end(), '\n'), ==, 3);
+
+      {
+        std::stringstream in(chunks);
+        size_t numChunks = 0;
+        size_t numChunkLines = 0;
+        while (true) {
+          LineGraph c;
+          if (!c.readChunk(&in)) break;
+          numChunks++;
+          numChunkLines += c.numLines();
+          if (numChunks < 3) {
+            TEST(c.numEdgs(), ==, 1);
+          } else {
+            TEST(c.numNds(), ==, 0);
+            TEST(c.getGraphProps().at("test").get<std::string>(), ==, "a");
+          }
+        }
+        TEST(numChunks, ==, 3);
+        TEST(numChunkLines, ==, 3);
+      }
+
+      // all chunks merged into a single graph
+      std::stringstream in(chunks);
+      LineGraph h;
+      h.readFromJson(&in, true);
+
+      TEST(h.getGraphProps().at("test").get<std::string>(), ==, "a");
+      TEST(h.getGraphProps().count("component"), ==, 0);
+
+      TEST(h.numEdgs(), ==, 2);
+      TEST(h.numLines(), ==, 3);
+
+      // each chunk is tagged with its own component id
+      std::set<uint32_t> ids;
+      for (auto nd : h.getNds()) {
+        for (auto e : nd->getAdjList()) {
+          TEST(e->pl().getComponent(), ==, nd->pl().getComponent());
+          TEST(e->pl().getComponent(), <, 2);
+          ids.insert(e->pl().getComponent());
+        }
+      }
+      TEST(ids.size(), ==, 2);
+    }
+  }
+}
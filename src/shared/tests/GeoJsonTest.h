@@ -0,0 +1,12 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#ifndef SHARED_TEST_GEOJSONTEST_H_
+#define SHARED_TEST_GEOJSONTEST_H_
+
+class GeoJsonTest {
+  public:
+    void run();
+};
+
+#endif
@@ -1,6 +1,8 @@
 // Copyright 2016
 // Author: Patrick Brosi
 
+#include "shared/tests/BinFormatTest.h"
+#include "shared/tests/GeoJsonTest.h"
 #include "shared/tests/ILPSolverTest.h"
 
 #include "util/Misc.h"
@@ -10,6 +12,10 @@ int main(int argc, char** argv) {
   UNUSED(argc);
   UNUSED(argv);
   ILPSolverTest gs;
+  BinFormatTest bft;
+  GeoJsonTest gjt;
 
   gs.run();
+  bft.run();
+  gjt.run();
 }
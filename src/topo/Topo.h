@@ -0,0 +1,33 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_TOPO_H_
+#define TOPO_TOPO_H_
+
+#include <vector>
+
+#include "shared/linegraph/ComponentWriter.h"
+#include "shared/linegraph/LineGraph.h"
+#include "topo/config/TopoConfig.h"
+#include "util/json/Writer.h"
+
+namespace topo {
+
+// Construct the overlap-free line graph from lg. The result is written to
+// res, one graph per connected component. Returns the statistics to be
+// written to the output graph properties, empty if none were requested.
+util::json::Dict run(const config::TopoConfig* cfg,
+                     shared::linegraph::LineGraph* lg,
+                     std::vector<shared::linegraph::LineGraph>* res);
+
+// as above, but each component is written to out as soon as it has been
+// processed, and is not kept in res afterwards
+util::json::Dict run(const config::TopoConfig* cfg,
+                     shared::linegraph::LineGraph* lg,
+                     std::vector<shared::linegraph::LineGraph>* res,
+                     shared::linegraph::ComponentWriter* out);
+
+}  // namespace topo
+
+#endif  // TOPO_TOPO_H_
@@ -44,6 +44,10 @@ void ConfigReader::help(const char* bin) const {
             << "maximum distance between segments\n"
             << std::setw(40) << "  --write-stats"
             << "write statistics to output file\n"
+            << std::setw(40) << "  --out-format arg (=json)"
+            << "output format, one of json, json-compact, bin\n"
+            << std::setw(40) << "  --stream"
+            << "write each component as soon as it is finished\n"
             << std::setw(40) << "  --no-infer-restrs"
             << "don't infer turn restrictions\n"
             << std::setw(40) << "  --infer-restr-max-dist arg (=[-d])"
@@ -91,6 +95,8 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
       {"smooth", required_argument, 0, 11},
       {"turn-restr-full-turn-angle", required_argument, 0, 12},
       {"aggr-stats", no_argument, 0, 13},
+      {"out-format", required_argument, 0, 14},
+      {"stream", no_argument, 0, 15},
       {0, 0, 0, 0}};
 
   double turnRestrDiff = -1;
@@ -146,6 +152,12 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
       case 13:
         cfg->aggregateStats = true;
         break;
+      case 14:
+        cfg->outputFormat = optarg;
+        break;
+      case 15:
+        cfg->stream = true;
+        break;
       case ':':
         std::cerr << argv[optind - 1];
         std::cerr << " requires an argument" << std::endl;
@@ -162,6 +174,12 @@ void ConfigReader::read(TopoConfig* cfg, int argc, char** argv) const {
     }
   }
 
+  if (cfg->outputFormat != "json" && cfg->outputFormat != "json-compact" &&
+      cfg->outputFormat != "bin") {
+    std::cerr << "Unknown output format " << cfg->outputFormat << std::endl;
+    exit(1);
+  }
+
   if (turnRestrDiff >= 0)
     cfg->maxTurnRestrCheckDist = turnRestrDiff;
   else
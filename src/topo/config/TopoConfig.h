@@ -25,6 +25,8 @@ struct TopoConfig {
   double connectedCompDist = 10000;
   double smooth = 0;
   std::string componentsPath = "";
+  std::string outputFormat = "json";
+  bool stream = false;
 };
 
 }  // namespace config
@@ -720,7 +720,7 @@ size_t MapConstructor::freeze() {
   for (auto nd : _g->getNds()) {
     for (auto* edg : nd->getAdjList()) {
       if (edg->getFrom() != nd) continue;
-      _origEdgs.back()[edg].insert(edg);
+      _origEdgs.back().add(edg);
     }
   }
 
@@ -729,7 +729,7 @@ size_t MapConstructor::freeze() {
 
 // _____________________________________________________________________________
 void MapConstructor::combContEdgs(const LineEdge* a, const LineEdge* b) {
-  for (auto& oe : _origEdgs) oe[a].insert(oe[b].begin(), oe[b].end());
+  for (auto& oe : _origEdgs) oe.merge(a, b);
 }
 
 // _____________________________________________________________________________
@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include "shared/linegraph/LineGraph.h"
 #include "topo/config/TopoConfig.h"
+#include "topo/mapconstructor/OrigEdgs.h"
 #include "topo/restr/RestrGraph.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
@@ -40,7 +41,7 @@ using shared::linegraph::Station;
 // typedef Grid<LineNode*, Point, double> NodeGeoIdx;
 typedef RTree<LineNode*, Point, double> NodeGeoIdx;
 
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
+using topo::OrigEdgs;
 
 namespace topo {
 
@@ -0,0 +1,64 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <iterator>
+
+#include "topo/mapconstructor/OrigEdgs.h"
+
+using shared::linegraph::LineEdge;
+using topo::OrigEdgs;
+
+// _____________________________________________________________________________
+void OrigEdgs::add(const LineEdge* e) {
+  auto& set = _sets[e];
+  uint32_t id = _orig.size();
+  _orig.push_back(e);
+
+  // ids are handed out in increasing order, so set stays sorted
+  if (set.empty() || set.back() < id) set.push_back(id);
+}
+
+// _____________________________________________________________________________
+void OrigEdgs::merge(const LineEdge* a, const LineEdge* b) {
+  // keep both edges tracked, even if b had no origins yet
+  const auto& setB = _sets[b];
+  auto& setA = _sets[a];
+
+  if (a == b || setB.empty()) return;
+
+  if (setA.empty()) {
+    setA = setB;
+    return;
+  }
+
+  std::vector<uint32_t> un;
+  un.reserve(setA.size() + setB.size());
+  std::set_union(setA.begin(), setA.end(), setB.begin(), setB.end(),
+                 std::back_inserter(un));
+  setA.swap(un);
+}
+
+// _____________________________________________________________________________
+void OrigEdgs::copy(const LineEdge* a, const LineEdge* b) {
+  if (a == b) return;
+  auto setB = _sets[b];
+  _sets[a] = std::move(setB);
+}
+
+// _____________________________________________________________________________
+void OrigEdgs::erase(const LineEdge* e) { _sets.erase(e); }
+
+// _____________________________________________________________________________
+size_t OrigEdgs::count(const LineEdge* e) const { return _sets.count(e); }
+
+// _____________________________________________________________________________
+size_t OrigEdgs::numOrig(const LineEdge* e) const {
+  return _sets.at(e).size();
+}
+
+// _____________________________________________________________________________
+const std::vector<uint32_t>& OrigEdgs::ids(const LineEdge* e) const {
+  return _sets.at(e);
+}
@@ -0,0 +1,51 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TOPO_MAPCONSTRUCTOR_ORIGEDGS_H_
+#define TOPO_MAPCONSTRUCTOR_ORIGEDGS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "shared/linegraph/LineGraph.h"
+
+namespace topo {
+
+using shared::linegraph::LineEdge;
+
+// Tracks for each edge of a graph the set of edges it originated from at some
+// freeze point. Original edges are identified by dense integer ids, the
+// origin set of each current edge is kept as a sorted id vector.
+class OrigEdgs {
+ public:
+  // add e as an original edge which originates from itself
+  void add(const LineEdge* e);
+
+  // add the origins of b to the origins of a
+  void merge(const LineEdge* a, const LineEdge* b);
+
+  // set the origins of a to the origins of b
+  void copy(const LineEdge* a, const LineEdge* b);
+
+  void erase(const LineEdge* e);
+  size_t count(const LineEdge* e) const;
+
+  // number of original edges e originates from, throws if e is not tracked
+  size_t numOrig(const LineEdge* e) const;
+
+  // sorted ids of the original edges e originates from, throws if e is not
+  // tracked
+  const std::vector<uint32_t>& ids(const LineEdge* e) const;
+
+  // the original edge with the given id
+  const LineEdge* orig(uint32_t id) const { return _orig[id]; }
+
+ private:
+  std::vector<const LineEdge*> _orig;
+  std::unordered_map<const LineEdge*, std::vector<uint32_t>> _sets;
+};
+
+}  // namespace topo
+
+#endif  // TOPO_MAPCONSTRUCTOR_ORIGEDGS_H_
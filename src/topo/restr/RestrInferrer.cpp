@@ -260,8 +260,8 @@ void RestrInferrer::addHndls(const LineEdge* e, const OrigEdgs& origEdgs,
   b = _rg.addNd(hndlLB.back());
   _rg.addEdg(a, b, RestrEdgePL(PolyLine<double>(hndlLB)));
 
-  for (auto edg : origEdgs.find(e)->second) {
-    auto origFr = const_cast<LineEdge*>(edg);
+  for (auto id : origEdgs.ids(e)) {
+    auto origFr = const_cast<LineEdge*>(origEdgs.orig(id));
     const auto& edgs = _eMap.find(origFr)->second;
 
     assert(edgs.size());
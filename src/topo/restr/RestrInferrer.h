@@ -10,6 +10,7 @@
 #include "shared/linegraph/Line.h"
 #include "shared/linegraph/LineGraph.h"
 #include "topo/config/TopoConfig.h"
+#include "topo/mapconstructor/OrigEdgs.h"
 #include "topo/restr/RestrGraph.h"
 #include "util/graph/EDijkstra.h"
 
@@ -29,7 +30,6 @@ using util::graph::EDijkstra;
 namespace topo {
 namespace restr {
 
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
 typedef std::pair<RestrNode*, double> Hndl;
 typedef std::vector<Hndl> HndlLst;
 
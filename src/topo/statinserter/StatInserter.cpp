@@ -110,14 +110,14 @@ void StatInserter::init() {
 // _____________________________________________________________________________
 StationOcc StatInserter::unserved(const std::vector<LineEdge*>& adj,
                                   const StationOcc& stationOcc,
-                                  const OrigEdgs& origEdgs) {
+                                  const OrigEdgs& origEdgs) const {
   StationOcc ret{stationOcc.stations, {}, {}, stationOcc.geom};
   std::set<const LineEdge*> contained;
   std::set<const shared::linegraph::Line*> containedLines;
 
-  for (auto e : adj)
-    contained.insert(origEdgs.find(e)->second.begin(),
-                     origEdgs.find(e)->second.end());
+  for (auto e : adj) {
+    for (auto id : origEdgs.ids(e)) contained.insert(origEdgs.orig(id));
+  }
 
   for (auto e : adj) {
     for (auto lo : e->pl().getLines()) {
@@ -145,13 +145,13 @@ StationOcc StatInserter::unserved(const std::vector<LineEdge*>& adj,
 std::pair<size_t, size_t> StatInserter::served(
     const std::vector<LineEdge*>& adj, const std::set<const LineEdge*>& toServe,
     const std::set<const shared::linegraph::Line*>& linesToServe,
-    const OrigEdgs& origEdgs) {
+    const OrigEdgs& origEdgs) const {
   std::set<const LineEdge*> contained;
   std::set<const shared::linegraph::Line*> containedLines;
 
-  for (auto e : adj)
-    contained.insert(origEdgs.find(e)->second.begin(),
-                     origEdgs.find(e)->second.end());
+  for (auto e : adj) {
+    for (auto id : origEdgs.ids(e)) contained.insert(origEdgs.orig(id));
+  }
 
   for (auto e : adj) {
     for (auto lo : e->pl().getLines()) {
@@ -174,7 +174,7 @@ std::pair<size_t, size_t> StatInserter::served(
 // _____________________________________________________________________________
 std::set<const shared::linegraph::Line*> StatInserter::wronglyServedLines(
     const std::vector<LineEdge*>& adj,
-    const std::set<const shared::linegraph::Line*>& linesToServe) {
+    const std::set<const shared::linegraph::Line*>& linesToServe) const {
   std::set<const shared::linegraph::Line*> containedLines;
   for (auto e : adj) {
     for (auto lo : e->pl().getLines()) {
@@ -191,7 +191,7 @@ std::set<const shared::linegraph::Line*> StatInserter::wronglyServedLines(
 }
 
 // _____________________________________________________________________________
-double StatInserter::candScore(const StationCand& c) {
+double StatInserter::candScore(const StationCand& c) const {
   double score = 0;
 
   score += c.dist;
@@ -218,17 +218,16 @@ double StatInserter::candScore(const StationCand& c) {
 }
 
 // _____________________________________________________________________________
-std::vector<StationCand> StatInserter::candidates(const StationOcc& occ,
-                                                  const EdgeGeoIdx& idx,
-                                                  const OrigEdgs& origEdgs) {
+std::vector<StationCand> StatInserter::candidates(
+    const StationOcc& occ, const EdgeGeoIdx& idx,
+    const OrigEdgs& origEdgs) const {
+  // called from parallel regions, does not log
   std::vector<StationCand> ret;
   std::set<LineEdge*> neighbors;
   idx.get(util::geo::pad(util::geo::getBoundingBox(occ.stations.front().pos),
                          4 * _cfg->maxAggrDistance),
           &neighbors);
 
-  LOGTO(VDEBUG, std::cerr) << "Got " << neighbors.size() << " candidates...";
-
   for (auto edg : neighbors) {
     auto pos = edg->pl().getPolyline().projectOn(occ.stations.front().pos);
     double d = util::geo::dist(pos.p, occ.geom);
@@ -238,40 +237,43 @@ std::vector<StationCand> StatInserter::candidates(const StationOcc& occ,
     // add whole edge as cand
     std::tie(truelyServed, truelyServedLines) =
         served({edg}, occ.edges, occ.lines, origEdgs);
-    StationOcc remaining = unserved({edg}, occ, origEdgs);
     ret.push_back(StationCand{edg, pos.totalPos, 0, d, occ.edges.size(),
-                              occ.lines.size(), truelyServed, truelyServedLines,
-                              remaining});
+                              occ.lines.size(), truelyServed,
+                              truelyServedLines});
 
     // add from node as cand
     std::tie(truelyServed, truelyServedLines) =
         served(edg->getFrom()->getAdjList(), occ.edges, occ.lines, origEdgs);
-    remaining = unserved(edg->getFrom()->getAdjList(), occ, origEdgs);
     ret.push_back(
         StationCand{0, 0, edg->getFrom(),
                     util::geo::dist(*edg->getFrom()->pl().getGeom(), occ.geom),
                     occ.edges.size(), occ.lines.size(), truelyServed,
-                    truelyServedLines, remaining});
+                    truelyServedLines});
 
     // add to node as cand
     std::tie(truelyServed, truelyServedLines) =
         served(edg->getTo()->getAdjList(), occ.edges, occ.lines, origEdgs);
-    remaining = unserved(edg->getTo()->getAdjList(), occ, origEdgs);
     ret.push_back(
         StationCand{0, 0, edg->getTo(),
                     util::geo::dist(*edg->getTo()->pl().getGeom(), occ.geom),
                     occ.edges.size(), occ.lines.size(), truelyServed,
-                    truelyServedLines, remaining});
+                    truelyServedLines});
   }
 
-  std::sort(ret.begin(), ret.end(),
-            [this](const StationCand& a, const StationCand& b) -> bool {
-              return candScore(a) < candScore(b);
-            });
+  std::stable_sort(ret.begin(), ret.end(),
+                   [this](const StationCand& a, const StationCand& b) -> bool {
+                     return candScore(a) < candScore(b);
+                   });
 
-  LOGTO(VDEBUG, std::cerr) << "  Cands for '" << occ.stations.front().name
-                           << "':";
-  for (auto cand : ret) {
+  return ret;
+}
+
+// _____________________________________________________________________________
+void StatInserter::logCands(const StationOcc& occ,
+                            const std::vector<StationCand>& cands) const {
+  LOGTO(VDEBUG, std::cerr) << "  " << cands.size() << " cands for '"
+                           << occ.stations.front().name << "':";
+  for (auto cand : cands) {
     if (cand.edg) {
       LOGTO(VDEBUG, std::cerr)
           << "    Edg " << cand.edg << " at position " << cand.pos
@@ -287,8 +289,6 @@ std::vector<StationCand> StatInserter::candidates(const StationOcc& occ,
           << occ.lines.size() << " lines (score: " << candScore(cand) << ")";
     }
   }
-
-  return ret;
 }
 
 // _____________________________________________________________________________
@@ -299,14 +299,37 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
   std::unordered_map<LineNode*, std::vector<std::pair<double, Station>>>
       newStats;
 
-  for (auto curOcc : _statClusters) {
+  // score the first round of candidates of all stations in parallel against
+  // the unmodified graph, the insertions below are then committed
+  // sequentially in the original station order
+  std::vector<std::vector<StationCand>> initCands(_statClusters.size());
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < _statClusters.size(); i++) {
+    initCands[i] = candidates(_statClusters[i], idx, modOrigEdgs);
+  }
+
+  // edges deleted and nodes whose adjacency changed by the insertions so far,
+  // candidates touching them have to be re-scored
+  std::set<const LineEdge*> dirtyEdgs;
+  std::set<const LineNode*> dirtyNds;
+
+  for (size_t j = 0; j < _statClusters.size(); j++) {
+    auto curOcc = _statClusters[j];
     LOGTO(DEBUG, std::cerr) << "Inserting " << curOcc.stations.front().name;
 
     int MAX_INSERTS = 3;
     int i = 0;
 
     while (i++ < MAX_INSERTS) {
-      auto cands = candidates(curOcc, idx, modOrigEdgs);
+      std::vector<StationCand> cands;
+      if (i == 1 && !stale(initCands[j], dirtyEdgs, dirtyNds)) {
+        cands = std::move(initCands[j]);
+      } else {
+        cands = candidates(curOcc, idx, modOrigEdgs);
+      }
+
+      logCands(curOcc, cands);
 
       if (cands.size() == 0) {
         LOGTO(DEBUG, std::cerr) << "  (No insertion candidate found.)";
@@ -320,9 +343,18 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
         break;
       }
 
+      // only computed for the chosen candidate, and before it is committed
+      StationOcc remaining =
+          curCan.edg ? unserved({curCan.edg}, curOcc, modOrigEdgs)
+                     : unserved(curCan.nd->getAdjList(), curOcc, modOrigEdgs);
+
       if (curCan.edg) {
         auto e = curCan.edg;
 
+        dirtyEdgs.insert(e);
+        dirtyNds.insert(e->getFrom());
+        dirtyNds.insert(e->getTo());
+
         auto spl = split(e->pl(), e->getFrom(), e->getTo(), curCan.pos);
 
         auto nd =
@@ -355,8 +387,8 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
         idx.add(*spl.second->pl().getGeom(), spl.second);
 
         // UPDATE ORIGEDGES
-        modOrigEdgs[spl.first] = modOrigEdgs[e];
-        modOrigEdgs[spl.second] = modOrigEdgs[e];
+        modOrigEdgs.copy(spl.first, e);
+        modOrigEdgs.copy(spl.second, e);
 
         edgeRpl(e->getFrom(), e, spl.first);
         edgeRpl(e->getTo(), e, spl.second);
@@ -391,15 +423,13 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
         }
       }
 
-      if (curCan.unserved.edges.size() == 0 &&
-          curCan.unserved.lines.size() == 0)
-        break;
+      if (remaining.edges.size() == 0 && remaining.lines.size() == 0) break;
 
       LOGTO(DEBUG, std::cerr)
-          << "  inserting for remaining " << curCan.unserved.edges.size()
-          << " unserved edges and/or " << curCan.unserved.lines.size()
+          << "  inserting for remaining " << remaining.edges.size()
+          << " unserved edges and/or " << remaining.lines.size()
           << " unserved lines...";
-      curOcc = curCan.unserved;
+      curOcc = remaining;
     }
   }
 
@@ -419,6 +449,20 @@ bool StatInserter::insertStations(const OrigEdgs& origEdgs) {
   return true;
 }
 
+// _____________________________________________________________________________
+bool StatInserter::stale(const std::vector<StationCand>& cands,
+                         const std::set<const LineEdge*>& dirtyEdgs,
+                         const std::set<const LineNode*>& dirtyNds) const {
+  // every neighbor edge yields an edge candidate and one candidate for each
+  // of its end nodes, so checking the candidates covers the whole
+  // neighborhood the scores depend on
+  for (const auto& c : cands) {
+    if (c.edg && dirtyEdgs.count(c.edg)) return true;
+    if (c.nd && dirtyNds.count(c.nd)) return true;
+  }
+  return false;
+}
+
 // _____________________________________________________________________________
 LineEdgePair StatInserter::split(LineEdgePL& a, LineNode* fr, LineNode* to,
                                  double p) {
@@ -10,6 +10,7 @@
 
 #include "shared/linegraph/LineGraph.h"
 #include "topo/config/TopoConfig.h"
+#include "topo/mapconstructor/OrigEdgs.h"
 #include "util/geo/Geo.h"
 #include "util/geo/Grid.h"
 #include "util/geo/PolyLine.h"
@@ -39,7 +40,7 @@ using shared::linegraph::Station;
 
 typedef RTree<LineEdge*, Line, double> EdgeGeoIdx;
 
-typedef std::unordered_map<const LineEdge*, std::set<const LineEdge*>> OrigEdgs;
+using topo::OrigEdgs;
 
 namespace topo {
 
@@ -65,8 +66,6 @@ struct StationCand {
 
   size_t truelyServ;
   size_t truelyServedLines;
-
-  StationOcc unserved;
 };
 
 class StatInserter {
@@ -82,25 +81,33 @@ class StatInserter {
 
   std::vector<StationCand> candidates(const StationOcc& occ,
                                       const EdgeGeoIdx& idx,
-                                      const OrigEdgs& origEdgs);
+                                      const OrigEdgs& origEdgs) const;
+
+  void logCands(const StationOcc& occ,
+                const std::vector<StationCand>& cands) const;
+
+  bool stale(const std::vector<StationCand>& cands,
+             const std::set<const LineEdge*>& dirtyEdgs,
+             const std::set<const LineNode*>& dirtyNds) const;
 
   DBox bbox() const;
   EdgeGeoIdx geoIndex();
 
-  double candScore(const StationCand& c);
+  double candScore(const StationCand& c) const;
 
   std::pair<size_t, size_t> served(
       const std::vector<LineEdge*>& adj,
       const std::set<const LineEdge*>& toServe,
       const std::set<const shared::linegraph::Line*>& linesToServe,
-      const OrigEdgs& origEdgs);
+      const OrigEdgs& origEdgs) const;
 
   std::set<const shared::linegraph::Line*> wronglyServedLines(
     const std::vector<LineEdge*>& adj,
-    const std::set<const shared::linegraph::Line*>& linesToServe);
+    const std::set<const shared::linegraph::Line*>& linesToServe) const;
 
   StationOcc unserved(const std::vector<LineEdge*>& adj,
-                      const StationOcc& stationOcc, const OrigEdgs& origEdgs);
+                      const StationOcc& stationOcc,
+                      const OrigEdgs& origEdgs) const;
 
   LineEdgePair split(LineEdgePL& a, LineNode* fr, LineNode* to, double p);
 
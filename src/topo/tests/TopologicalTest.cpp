@@ -1136,4 +1136,146 @@ void TopologicalTest::run() {
       TEST(e->pl().getLines().begin()->direction, ==, 0);
     }
   }
+  // ___________________________________________________________________________
+  {
+    //         b
+    //         |
+    //       1 |
+    // a ------x-----> c
+    //    2->  |
+    //         d
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 50.0}});
+    auto b = tg.addNd({{100.0, 200.0}});
+    auto c = tg.addNd({{200.0, 50.0}});
+    auto d = tg.addNd({{100.0, 0.0}});
+
+    auto ac = tg.addEdg(a, c, {{{0.0, 50.0}, {200.0, 50.0}}});
+    auto db = tg.addEdg(d, b, {{{100.0, 0.0}, {100.0, 200.0}}});
+
+    tg.getEdgGrid()->add(*ac->pl().getGeom(), ac);
+    tg.getEdgGrid()->add(*db->pl().getGeom(), db);
+
+    shared::linegraph::Line l1("1", "1", "red");
+    shared::linegraph::Line l2("2", "2", "blue");
+
+    ac->pl().addLine(&l2, c);
+    db->pl().addLine(&l1, 0);
+
+    tg.topologizeIsects();
+
+    TEST(tg.getNds().size(), ==, 5);
+    TEST(tg.numEdgs(), ==, 4);
+    TEST(a->getDeg(), ==, 1);
+    TEST(b->getDeg(), ==, 1);
+    TEST(c->getDeg(), ==, 1);
+    TEST(d->getDeg(), ==, 1);
+
+    auto x = a->getAdjList().front()->getOtherNd(a);
+    TEST(x->getDeg(), ==, 4);
+    TEST(util::geo::dist(*x->pl().getGeom(), util::geo::DPoint(100, 50)), <,
+         0.001);
+
+    TEST(a->getAdjList().front()->pl().lineOcc(&l2).direction, ==, x);
+    TEST(c->getAdjList().front()->pl().lineOcc(&l2).direction, ==, c);
+    TEST(b->getAdjList().front()->pl().lineOcc(&l1).direction, ==, 0);
+    TEST(d->getAdjList().front()->pl().hasLine(&l1));
+    TEST(!d->getAdjList().front()->pl().hasLine(&l2));
+  }
+  // ___________________________________________________________________________
+  {
+    //       b   f
+    //       |  /
+    //       | /
+    // a ----x-----> c
+    //      /|
+    //     / |
+    //    e  d
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 50.0}});
+    auto b = tg.addNd({{100.0, 200.0}});
+    auto c = tg.addNd({{200.0, 50.0}});
+    auto d = tg.addNd({{100.0, 0.0}});
+    auto e = tg.addNd({{0.0, -50.0}});
+    auto f = tg.addNd({{200.0, 150.0}});
+
+    auto ac = tg.addEdg(a, c, {{{0.0, 50.0}, {200.0, 50.0}}});
+    auto db = tg.addEdg(d, b, {{{100.0, 0.0}, {100.0, 200.0}}});
+    auto ef = tg.addEdg(e, f, {{{0.0, -50.0}, {200.0, 150.0}}});
+
+    tg.getEdgGrid()->add(*ac->pl().getGeom(), ac);
+    tg.getEdgGrid()->add(*db->pl().getGeom(), db);
+    tg.getEdgGrid()->add(*ef->pl().getGeom(), ef);
+
+    shared::linegraph::Line l1("1", "1", "red");
+    shared::linegraph::Line l2("2", "2", "blue");
+    shared::linegraph::Line l3("3", "3", "green");
+
+    ac->pl().addLine(&l1, 0);
+    db->pl().addLine(&l2, 0);
+    ef->pl().addLine(&l3, 0);
+
+    tg.topologizeIsects();
+
+    // all three crossings are merged into a single node
+    TEST(tg.getNds().size(), ==, 7);
+    TEST(tg.numEdgs(), ==, 6);
+
+    auto x = a->getAdjList().front()->getOtherNd(a);
+    TEST(x->getDeg(), ==, 6);
+    TEST(util::geo::dist(*x->pl().getGeom(), util::geo::DPoint(100, 50)), <,
+         0.001);
+
+    for (auto nd : {a, b, c, d, e, f}) {
+      TEST(nd->getDeg(), ==, 1);
+      TEST(nd->getAdjList().front()->getOtherNd(nd), ==, x);
+    }
+
+    TEST(f->getAdjList().front()->pl().hasLine(&l3));
+    TEST(!f->getAdjList().front()->pl().hasLine(&l1));
+  }
+  // ___________________________________________________________________________
+  {
+    // as above, but e-f crosses a-c and d-b slightly off their crossing, the
+    // sub edges nevertheless end exactly at the merged node
+    shared::linegraph::LineGraph tg;
+    auto a = tg.addNd({{0.0, 50.0}});
+    auto b = tg.addNd({{100.0, 200.0}});
+    auto c = tg.addNd({{200.0, 50.0}});
+    auto d = tg.addNd({{100.0, 0.0}});
+    auto e = tg.addNd({{0.5, -50.0}});
+    auto f = tg.addNd({{200.5, 150.0}});
+
+    auto ac = tg.addEdg(a, c, {{{0.0, 50.0}, {200.0, 50.0}}});
+    auto db = tg.addEdg(d, b, {{{100.0, 0.0}, {100.0, 200.0}}});
+    auto ef = tg.addEdg(e, f, {{{0.5, -50.0}, {200.5, 150.0}}});
+
+    tg.getEdgGrid()->add(*ac->pl().getGeom(), ac);
+    tg.getEdgGrid()->add(*db->pl().getGeom(), db);
+    tg.getEdgGrid()->add(*ef->pl().getGeom(), ef);
+
+    shared::linegraph::Line l1("1", "1", "red");
+    ac->pl().addLine(&l1, 0);
+    db->pl().addLine(&l1, 0);
+    ef->pl().addLine(&l1, 0);
+
+    tg.topologizeIsects();
+
+    TEST(tg.getNds().size(), ==, 7);
+    TEST(tg.numEdgs(), ==, 6);
+
+    auto x = a->getAdjList().front()->getOtherNd(a);
+    TEST(x->getDeg(), ==, 6);
+
+    for (auto edg : x->getAdjList()) {
+      const auto& geom = edg->pl().getPolyline().getLine();
+      const auto& end = edg->getFrom() == x ? geom.front() : geom.back();
+      const auto& start = edg->getFrom() == x ? geom.back() : geom.front();
+      TEST(end.getX(), ==, x->pl().getGeom()->getX());
+      TEST(end.getY(), ==, x->pl().getGeom()->getY());
+
+      auto other = edg->getOtherNd(x);
+      TEST(util::geo::dist(start, *other->pl().getGeom()), <, 0.001);
+    }
+  }
 }
@@ -0,0 +1,221 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/TransitMap.h"
+#include "transitmap/graph/GraphBuilder.h"
+#include "transitmap/output/MbTilesArchive.h"
+#include "transitmap/output/MvtRenderer.h"
+#include "transitmap/output/PmTilesArchive.h"
+#include "transitmap/output/SvgRenderer.h"
+#include "util/log/Log.h"
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#define omp_get_max_threads() 1
+#endif
+
+using shared::linegraph::LineGraph;
+using shared::linegraph::LineNode;
+using shared::rendergraph::RenderGraph;
+using transitmapper::graph::GraphBuilder;
+
+// maximum number of zoom levels for which render graphs are held at once
+static const int MAX_PREP_ZOOMS = 4;
+
+#ifdef PROTOBUF_FOUND
+// node positions, to identify nodes across the render graphs of different
+// zoom levels
+typedef std::set<std::pair<double, double>> NdPosSet;
+
+// _____________________________________________________________________________
+static std::pair<double, double> ndPos(const LineNode* n) {
+  return {n->pl().getGeom()->getX(), n->pl().getGeom()->getY()};
+}
+
+// _____________________________________________________________________________
+static RenderGraph* prepZoom(const transitmapper::config::Config* cfg,
+                             const RenderGraph& base, size_t z,
+                             const NdPosSet* cands, NdPosSet* expanded) {
+  // build the render graph of zoom level z from base. If cands is set, only
+  // the node fronts at these positions are checked for overlaps in the first
+  // expansion. If expanded is set, the positions of all nodes whose fronts
+  // were shrunk in the first expansion are added to it.
+  double lWidth = cfg->lineWidth * 156543.0 / (1 << z);
+  double lSpacing = cfg->lineSpacing * 156543.0 / (1 << z);
+  double lOutlineWidth = cfg->outlineWidth * 156543.0 / (1 << z);
+
+  RenderGraph* g = new RenderGraph(base, lWidth, lOutlineWidth, lSpacing);
+
+  try {
+    // the graph builder caches per-graph state
+    GraphBuilder zb(cfg);
+
+    zb.writeNodeFronts(g);
+
+    std::vector<LineNode*> shrunk;
+    if (cands) {
+      std::vector<LineNode*> nds;
+      for (auto n : g->getNds()) {
+        if (cands->count(ndPos(n))) nds.push_back(n);
+      }
+      shrunk = zb.expandOverlappinFronts(g, nds);
+    } else {
+      shrunk = zb.expandOverlappinFronts(g);
+    }
+
+    if (expanded) {
+      for (auto n : shrunk) expanded->insert(ndPos(n));
+    }
+
+    g->createMetaNodes();
+
+    // avoid overlapping stations
+    if (true) {
+      zb.dropOverlappingStations(g);
+      g->contractStrayNds();
+      zb.expandOverlappinFronts(g);
+      g->createMetaNodes();
+    }
+  } catch (...) {
+    delete g;
+    throw;
+  }
+
+  return g;
+}
+#endif
+
+// _____________________________________________________________________________
+void transitmapper::run(const config::Config* cfg, LineGraph* lg,
+                        std::ostream* out) {
+  GraphBuilder b(cfg);
+
+  if (cfg->randomColors) lg->fillMissingColors();
+
+  // snap orphan stations
+  lg->snapOrphanStations();
+
+  if (cfg->renderMethod == "mvt") {
+#ifdef PROTOBUF_FOUND
+    // a single archive holds the tiles of all zoom levels
+    std::unique_ptr<transitmapper::output::TileArchive> archive;
+    if (cfg->mvtArchive == "pmtiles") {
+      archive.reset(new transitmapper::output::PmTilesArchive(
+          cfg->mvtPath, cfg->mvtGzip));
+    }
+#ifdef SQLITE3_FOUND
+    if (cfg->mvtArchive == "mbtiles") {
+      archive.reset(new transitmapper::output::MbTilesArchive(
+          cfg->mvtPath, cfg->mvtGzip));
+    }
+#endif
+
+    // the zoom-independent preprocessing is only done once
+    RenderGraph base(std::move(*lg), cfg->lineWidth, cfg->outlineWidth,
+                     cfg->lineSpacing);
+    base.contractStrayNds();
+    base.smooth(cfg->inputSmoothing);
+
+    // node fronts depend on the line widths, which are scaled per zoom level.
+    // All widths are scaled by the same factor, and with narrower lines, the
+    // fronts at a node are shorter and overlap less. So fronts only have to
+    // be shrunk at nodes where they were shrunk on the zoom level with the
+    // widest lines, which is prepared first for reference.
+    size_t refI = std::min_element(cfg->mvtZooms.begin(), cfg->mvtZooms.end()) -
+                  cfg->mvtZooms.begin();
+
+    NdPosSet cands;
+    std::unique_ptr<RenderGraph> ref;
+    if (cfg->mvtZooms.size()) {
+      ref.reset(prepZoom(cfg, base, cfg->mvtZooms[refI], 0, &cands));
+    }
+
+    // The remaining render graphs are prepared in parallel, but only for a
+    // few zoom levels at once, each of them is freed right after it was
+    // rendered.
+    size_t batch = std::max(1, std::min(omp_get_max_threads(), MAX_PREP_ZOOMS));
+
+    for (size_t start = 0; start < cfg->mvtZooms.size(); start += batch) {
+      size_t end = std::min(start + batch, cfg->mvtZooms.size());
+      std::vector<RenderGraph*> graphs(end - start, 0);
+      std::string err;
+
+      if (refI >= start && refI < end) graphs[refI - start] = ref.release();
+
+#pragma omp parallel for schedule(dynamic)
+      for (size_t i = start; i < end; i++) {
+        if (i == refI) continue;
+
+        try {
+          graphs[i - start] =
+              prepZoom(cfg, base, cfg->mvtZooms[i], &cands, 0);
+        } catch (const std::exception& e) {
+#pragma omp critical
+          err = e.what();
+        }
+      }
+
+      if (!err.empty()) {
+        for (auto g : graphs) delete g;
+        throw std::runtime_error(err);
+      }
+
+      // tiles of a single zoom level are already written in parallel
+      for (size_t i = start; i < end; i++) {
+        LOGTO(DEBUG, std::cerr) << "Outputting zoom " << cfg->mvtZooms[i]
+                                << " to MVT ...";
+        transitmapper::output::MvtRenderer mvtOut(cfg, cfg->mvtZooms[i],
+                                                  archive.get());
+        mvtOut.print(*graphs[i - start]);
+        delete graphs[i - start];
+        graphs[i - start] = 0;
+      }
+    }
+
+    if (archive) {
+      archive->finish();
+      LOGTO(DEBUG, std::cerr) << "Wrote " << archive->numTiles() << " tiles ("
+                              << archive->numContents() << " unique) to "
+                              << cfg->mvtPath;
+    }
+#else
+    LOG(ERROR) << "transitmap was not compiled with protocol buffers support, "
+                  "cannot use render method "
+               << cfg->renderMethod;
+    exit(1);
+#endif
+  } else if (cfg->renderMethod == "svg") {
+    RenderGraph g(std::move(*lg), cfg->lineWidth, cfg->outlineWidth,
+                  cfg->lineSpacing);
+
+    g.contractStrayNds();
+    g.smooth(cfg->inputSmoothing);
+    b.writeNodeFronts(&g);
+    b.expandOverlappinFronts(&g);
+    g.createMetaNodes();
+
+    if (true) {
+      b.dropOverlappingStations(&g);
+      g.contractStrayNds();
+      b.expandOverlappinFronts(&g);
+      g.createMetaNodes();
+    }
+
+    LOGTO(DEBUG, std::cerr) << "Outputting to SVG ...";
+    transitmapper::output::SvgRenderer svgOut(out, cfg);
+    svgOut.print(g);
+  } else {
+    LOG(ERROR) << "Unknown render method " << cfg->renderMethod;
+    exit(1);
+  }
+}
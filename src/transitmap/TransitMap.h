@@ -0,0 +1,22 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_TRANSITMAP_H_
+#define TRANSITMAP_TRANSITMAP_H_
+
+#include <ostream>
+
+#include "shared/linegraph/LineGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+
+namespace transitmapper {
+
+// Render lg, either as SVG to out or as vector tiles below cfg->mvtPath.
+// lg is consumed.
+void run(const config::Config* cfg, shared::linegraph::LineGraph* lg,
+         std::ostream* out);
+
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_TRANSITMAP_H_
@@ -60,11 +60,30 @@ void ConfigReader::help(const char* bin) const {
             << "textsize for station labels\n"
             << std::setw(37) << "  --no-deg2-labels"
             << "no labels for deg-2 stations\n"
+            << std::setw(37) << "  --svg-precision arg (=-1)"
+            << "decimal places of quantized SVG coordinates, -1 for none\n"
+            << std::setw(37) << "  --svg-tile-size arg (=0)"
+            << "write SVG tiles of this size, 0 for a single SVG\n"
+            << std::setw(37) << "  --svg-tile-path arg (=.)"
+            << "path for SVG tiles\n"
+            << std::setw(37) << "  --svg-lods arg (=1)"
+            << "number of SVG tile levels of detail\n"
 #ifdef PROTOBUF_FOUND
             << std::setw(37) << "  -z [ --zoom ] (=14)"
             << "zoom level to write for MVT tiles, comma separated or range\n"
             << std::setw(37) << "  --mvt-path (=.)"
-            << "path for MVT tiles\n\n"
+            << "path for MVT tiles, or archive file\n"
+            << std::setw(37) << "  --mvt-archive arg"
+#ifdef SQLITE3_FOUND
+            << "write tiles to a single archive, 'mbtiles' or 'pmtiles'\n"
+#else
+            << "write tiles to a single archive, only 'pmtiles' supported\n"
+#endif
+#ifdef ZLIB_FOUND
+            << std::setw(37) << "  --mvt-gzip"
+            << "gzip tiles in the archive\n"
+#endif
+            << "\n"
 #endif
             << "Misc:\n"
             << std::setw(37) << "  -D [ --from-dot ]"
@@ -114,9 +133,17 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
                          {"mvt-path", required_argument, 0, 17},
                          {"random-colors", no_argument, 0, 18},
                          {"print-stats", no_argument, 0, 19},
+                         {"mvt-archive", required_argument, 0, 20},
+                         {"mvt-gzip", no_argument, 0, 21},
+                         {"svg-precision", required_argument, 0, 22},
+                         {"svg-tile-size", required_argument, 0, 23},
+                         {"svg-tile-path", required_argument, 0, 24},
+                         {"svg-lods", required_argument, 0, 25},
                          {0, 0, 0, 0}};
 
   std::string zoom;
+  int svgPrecision = cfg->svgPrecision;
+  int svgLods = cfg->svgLods;
 
   int c;
   while ((c = getopt_long(argc, argv, ":hvlDz:", ops, 0)) != -1) {
@@ -184,6 +211,24 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
       case 19:
         cfg->writeStats = true;
         break;
+      case 20:
+        cfg->mvtArchive = optarg;
+        break;
+      case 21:
+        cfg->mvtGzip = true;
+        break;
+      case 22:
+        svgPrecision = atoi(optarg);
+        break;
+      case 23:
+        cfg->svgTileSize = atof(optarg);
+        break;
+      case 24:
+        cfg->svgTilePath = optarg;
+        break;
+      case 25:
+        svgLods = atoi(optarg);
+        break;
       case 'D':
         cfg->fromDot = true;
         break;
@@ -218,6 +263,28 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
     exit(1);
   }
 
+  if (svgPrecision < -1 || svgPrecision > 9) {
+    std::cerr << "Error: SVG precision " << svgPrecision
+              << " is not between -1 and 9!" << std::endl;
+    exit(1);
+  }
+
+  cfg->svgPrecision = svgPrecision;
+
+  if (cfg->svgTileSize < 0) {
+    std::cerr << "Error: SVG tile size " << cfg->svgTileSize
+              << " is negative!" << std::endl;
+    exit(1);
+  }
+
+  if (svgLods < 1 || svgLods > 16) {
+    std::cerr << "Error: number of SVG levels of detail " << svgLods
+              << " is not between 1 and 16!" << std::endl;
+    exit(1);
+  }
+
+  cfg->svgLods = svgLods;
+
   for (auto range : util::split(zoom, ',')) {
     util::replaceAll(range, " ", "");
     util::replaceAll(range, "=", "");
@@ -248,6 +315,41 @@ void ConfigReader::read(Config* cfg, int argc, char** argv) const {
 
   if (cfg->mvtZooms.size() == 0) cfg->mvtZooms.push_back(14);
 
+  if (!cfg->mvtArchive.empty() && cfg->mvtArchive != "pmtiles" &&
+      cfg->mvtArchive != "mbtiles") {
+    std::cerr << "Error: unknown tile archive format " << cfg->mvtArchive
+              << std::endl;
+    exit(1);
+  }
+
+#ifndef SQLITE3_FOUND
+  if (cfg->mvtArchive == "mbtiles") {
+    std::cerr << "Error: transitmap was not compiled with SQLite support, "
+                 "cannot write mbtiles"
+              << std::endl;
+    exit(1);
+  }
+#endif
+
+#ifndef ZLIB_FOUND
+  if (cfg->mvtGzip) {
+    std::cerr << "Error: transitmap was not compiled with zlib support, "
+                 "cannot gzip tiles"
+              << std::endl;
+    exit(1);
+  }
+#endif
+
+  if (cfg->mvtGzip && cfg->mvtArchive.empty()) {
+    std::cerr << "Error: --mvt-gzip requires --mvt-archive" << std::endl;
+    exit(1);
+  }
+
+  // the default tile path is a directory, use a file in it for archives
+  if (!cfg->mvtArchive.empty() && cfg->mvtPath == ".") {
+    cfg->mvtPath = "tiles." + cfg->mvtArchive;
+  }
+
   if (cfg->outputPadding < 0) {
     cfg->outputPadding = (cfg->lineWidth + cfg->lineSpacing);
   }
@@ -21,9 +21,23 @@ struct Config {
 
   std::string mvtPath = ".";
 
+  // if set, MVT tiles are written into a single archive file, either
+  // mbtiles or pmtiles
+  std::string mvtArchive;
+  bool mvtGzip = false;
+
   bool writeStats = false;
 
   double outputResolution = 0.1;
+
+  // decimal places of SVG coordinates
+  int svgPrecision = -1;
+
+  // if > 0, the SVG is written as a grid of tiles of this size into
+  // svgTilePath, with svgLods levels of detail
+  double svgTileSize = 0;
+  std::string svgTilePath = ".";
+  size_t svgLods = 1;
   double inputSmoothing = 1;
   double innerGeometryPrecision = 3;
 
@@ -2,6 +2,8 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <cmath>
 #include <istream>
 #include <set>
 #include <stack>
@@ -22,6 +24,7 @@ using shared::rendergraph::OrderCfg;
 using shared::rendergraph::Ordering;
 using shared::rendergraph::RenderGraph;
 using transitmapper::graph::GraphBuilder;
+using transitmapper::graph::NodeFrontState;
 using util::geo::DPoint;
 using util::geo::LinePoint;
 using util::geo::LinePointCmp;
@@ -109,130 +112,187 @@ void GraphBuilder::dropOverlappingStations(RenderGraph* graph) {
 }
 
 // _____________________________________________________________________________
-void GraphBuilder::expandOverlappinFronts(RenderGraph* g) {
+std::vector<LineNode*> GraphBuilder::expandOverlappinFronts(RenderGraph* g) {
+  return expandOverlappinFronts(
+      g, std::vector<LineNode*>(g->getNds().begin(), g->getNds().end()));
+}
+
+// _____________________________________________________________________________
+std::vector<LineNode*> GraphBuilder::expandOverlappinFronts(
+    RenderGraph* g, const std::vector<LineNode*>& nds) {
   // now, look at the nodes entire front geometries and expand them
   // until nothing overlaps
   double step =
       (g->getWidth(0) + g->getSpacing(0) + 2 * g->getOutlineWidth(0)) / 10;
 
-  while (true) {
-    bool stillFree = false;
-    for (auto n : g->getNds()) {
-      std::set<NodeFront*> overlaps = nodeGetOverlappingFronts(g, n);
-      for (auto f : overlaps) {
-        stillFree = true;
-        double len = util::geo::len(*f->edge->pl().getGeom());
-
-        if (f->edge->getTo() == n) {
-          double d = fmax(MINL - 1, len - step);
-          f->geom = PolyLine<double>(*f->edge->pl().getGeom())
-                        .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
-
-          f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
-                                    .getSegmentAtDist(0, d)
-                                    .getLine());
-
-        } else {
-          double d = fmin(step, len - MINL + 1);
-          f->geom = PolyLine<double>(*f->edge->pl().getGeom())
-                        .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
-
-          f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
-                                    .getSegmentAtDist(d, len)
-                                    .getLine());
-
-          f->geom.reverse();
-        }
+  std::vector<LineNode*> ret;
+
+  // shrinking the fronts of a node cannot introduce overlaps at other nodes,
+  // so only nodes whose fronts changed have to be checked again
+  std::vector<LineNode*> work(nds);
+
+  while (!work.empty()) {
+    std::vector<std::vector<double>> shrinks(work.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < work.size(); i++) {
+      shrinks[i] = nodeFrontShrinks(g, work[i], step);
+    }
+
+    // fronts are changed sequentially, as an edge may be shrunk at both ends
+    std::vector<LineNode*> changed;
+    for (size_t i = 0; i < work.size(); i++) {
+      bool ch = false;
+      for (size_t j = 0; j < shrinks[i].size(); j++) {
+        if (shrinks[i][j] <= 0) continue;
+        shrinkFront(g, work[i], &work[i]->pl().fronts()[j], shrinks[i][j]);
+        ch = true;
       }
+      if (ch) changed.push_back(work[i]);
     }
-    if (!stillFree) break;
+
+    ret.insert(ret.end(), changed.begin(), changed.end());
+    work = changed;
   }
 
-  // for (auto n : g->getNds()) {
-    // std::vector<util::geo::DLine> lines;
-    // for (size_t i = 0; i < n->pl().fronts().size(); ++i) {
-      // const NodeFront& f = n->pl().fronts()[i];
-      // lines.push_back(f.geom.getLine());
-    // }
+  return ret;
+}
 
-    // auto hull = util::geo::convexHull(lines);
+// _____________________________________________________________________________
+void GraphBuilder::shrinkFront(RenderGraph* g, const LineNode* n, NodeFront* f,
+                               double s) const {
+  double len = util::geo::len(*f->edge->pl().getGeom());
 
-    // for (size_t i = 0; i < n->pl().fronts().size(); ++i) {
-      // NodeFront& f = n->pl().fronts()[i];
+  if (f->edge->getTo() == n) {
+    double d = fmax(MINL - 1, len - s);
+    f->geom = PolyLine<double>(*f->edge->pl().getGeom())
+                  .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
 
-      // auto isects = PolyLine<double>(*f.edge->pl().getGeom()).getIntersections(hull.getOuter());
+    f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
+                              .getSegmentAtDist(0, d)
+                              .getLine());
 
-      // if (isects.size() == 0) continue;
+  } else {
+    double d = fmin(s, len - MINL + 1);
+    f->geom = PolyLine<double>(*f->edge->pl().getGeom())
+                  .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
 
-      // if (f.edge->getTo() == n) {
-        // f.geom = PolyLine<double>(*f.edge->pl().getGeom())
-                      // .getOrthoLineAt(isects.rbegin()->totalPos, g->getTotalWidth(f.edge));
+    f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
+                              .getSegmentAtDist(d, len)
+                              .getLine());
 
-        // f.edge->pl().setGeom(PolyLine<double>(*f.edge->pl().getGeom())
-                                  // .getSegment(0, isects.rbegin()->totalPos)
-                                  // .getLine());
-      // } else {
-        // f.geom = PolyLine<double>(*f.edge->pl().getGeom())
-                      // .getOrthoLineAt(isects.begin()->totalPos, g->getTotalWidth(f.edge));
+    f->geom.reverse();
+  }
+}
 
-        // f.edge->pl().setGeom(PolyLine<double>(*f.edge->pl().getGeom())
-                                  // .getSegment(isects.begin()->totalPos, 1)
-                                  // .getLine());
-        // f.geom.reverse();
-      // }
-    // }
-  // }
+// _____________________________________________________________________________
+NodeFrontState GraphBuilder::shrunkFront(const RenderGraph* g,
+                                         const LineNode* n, const NodeFront& f,
+                                         const PolyLine<double>& edgeGeom,
+                                         double s) const {
+  double len = edgeGeom.getLength();
+
+  if (f.edge->getTo() == n) {
+    double d = fmax(MINL - 1, len - s);
+    return {edgeGeom.getOrthoLineAtDist(d, g->getTotalWidth(f.edge)), d};
+  }
+
+  double d = fmin(s, len - MINL + 1);
+  auto geom = edgeGeom.getOrthoLineAtDist(d, g->getTotalWidth(f.edge));
+  geom.reverse();
+  return {geom, len - d};
 }
 
 // _____________________________________________________________________________
-std::set<NodeFront*> GraphBuilder::nodeGetOverlappingFronts(
-    const RenderGraph* g, const LineNode* n) const {
-  std::set<NodeFront*> ret;
+std::vector<double> GraphBuilder::nodeFrontShrinks(const RenderGraph* g,
+                                                   const LineNode* n,
+                                                   double step) const {
+  const auto& fronts = n->pl().fronts();
+  std::vector<double> shrinks(fronts.size(), 0);
+
+  std::vector<NodeFrontState> st;
+  for (const auto& f : fronts) {
+    st.push_back({f.geom, util::geo::len(*f.edge->pl().getGeom())});
+  }
 
-  // TODO: why are nodefronts accessed via index?
-  for (size_t i = 0; i < n->pl().fronts().size(); ++i) {
-    const NodeFront& fa = n->pl().fronts()[i];
+  auto ovl = nodeGetOverlappingFronts(g, n, st);
+  if (ovl.empty()) return shrinks;
+
+  std::vector<PolyLine<double>> edgeGeoms;
+  for (const auto& f : fronts) {
+    edgeGeoms.push_back(PolyLine<double>(*f.edge->pl().getGeom()));
+  }
 
-    for (size_t j = i + 1; j < n->pl().fronts().size(); ++j) {
-      const NodeFront& fb = n->pl().fronts()[j];
+  // overlapping fronts are shrunk step by step until no front overlaps
+  // anymore, as in the step-wise expansion on the graph. The set of
+  // overlapping fronts is not monotonic in the number of steps, so no step
+  // is skipped. Fronts shrunk to the minimum edge length are never reported
+  // as overlapping, so this terminates.
+  while (!ovl.empty()) {
+    for (size_t i : ovl) {
+      shrinks[i] += step;
+      st[i] = shrunkFront(g, n, fronts[i], edgeGeoms[i], shrinks[i]);
+    }
+    ovl = nodeGetOverlappingFronts(g, n, st);
+  }
 
-      if (fa.geom.equals(fb.geom, 5) || j == i) continue;
+  return shrinks;
+}
 
-      bool overlap = false;
+// _____________________________________________________________________________
+std::set<size_t> GraphBuilder::nodeGetOverlappingFronts(
+    const RenderGraph* g, const LineNode* n,
+    const std::vector<NodeFrontState>& st) const {
+  std::set<size_t> ret;
+
+  const auto& fronts = n->pl().fronts();
+  bool station = n->pl().stops().size() && !g->notCompletelyServed(n);
+
+  double maxNfDist = 2 * g->getMaxNdFrontWidth(n);
+  if (station) {
+    maxNfDist = .5 * g->getMaxNdFrontWidth(n);
+    if (_cfg->tightStations)
+      maxNfDist =
+          g->getWidth(0) + g->getSpacing(0) + 2 * g->getOutlineWidth(0);
+  }
+
+  for (size_t i = 0; i < fronts.size(); ++i) {
+    const NodeFront& fa = fronts[i];
+
+    for (size_t j = i + 1; j < fronts.size(); ++j) {
+      const NodeFront& fb = fronts[j];
 
-      double maxNfDist = 2 * g->getMaxNdFrontWidth(n);
+      if (st[i].geom.equals(st[j].geom, 5)) continue;
 
-      if (n->pl().stops().size() && !g->notCompletelyServed(n)) {
-        maxNfDist = .5 * g->getMaxNdFrontWidth(n);
+      bool overlap = false;
+
+      if (station) {
         double fac = 0;
-        if (_cfg->tightStations)
-          maxNfDist =
-              g->getWidth(0) + g->getSpacing(0) + 2 * g->getOutlineWidth(0);
-        overlap =
-            nodeFrontsOverlap(g, fa, fb,
-                              (g->getWidth(fa.edge) + g->getSpacing(fa.edge) +
-                               2 * g->getOutlineWidth(fa.edge)) *
-                                  fac);
+        overlap = nodeFrontsOverlap(
+            g, st[i].geom, st[j].geom,
+            (g->getWidth(fa.edge) + g->getSpacing(fa.edge) +
+             2 * g->getOutlineWidth(fa.edge)) *
+                fac);
       } else {
         size_t numShr = g->getSharedLines(fa.edge, fb.edge).size();
         double fac = 5;
         if (!numShr) fac = 1;
 
         overlap = nodeFrontsOverlap(
-            g, fa, fb,
+            g, st[i].geom, st[j].geom,
             (g->getWidth(fa.edge) + 2 * g->getOutlineWidth(fa.edge) +
              g->getSpacing(fa.edge)) *
                 fac);
       }
 
       if (overlap) {
-        if (util::geo::len(*fa.edge->pl().getGeom()) > MINL &&
-            fa.geom.distTo(*n->pl().getGeom()) < maxNfDist) {
-          ret.insert(const_cast<NodeFront*>(&fa));
+        if (st[i].len > MINL &&
+            st[i].geom.distTo(*n->pl().getGeom()) < maxNfDist) {
+          ret.insert(i);
         }
-        if (util::geo::len(*fb.edge->pl().getGeom()) > MINL &&
-            fb.geom.distTo(*n->pl().getGeom()) < maxNfDist) {
-          ret.insert(const_cast<NodeFront*>(&fb));
+        if (st[j].len > MINL &&
+            st[j].geom.distTo(*n->pl().getGeom()) < maxNfDist) {
+          ret.insert(j);
         }
       }
     }
@@ -242,8 +302,10 @@ std::set<NodeFront*> GraphBuilder::nodeGetOverlappingFronts(
 }
 
 // _____________________________________________________________________________
-bool GraphBuilder::nodeFrontsOverlap(const RenderGraph* g, const NodeFront& a,
-                                     const NodeFront& b, double d) const {
+bool GraphBuilder::nodeFrontsOverlap(const RenderGraph* g,
+                                     const PolyLine<double>& a,
+                                     const PolyLine<double>& b,
+                                     double d) const {
   UNUSED(g);
-  return b.geom.distTo(a.geom) <= d;
+  return b.distTo(a) <= d;
 }
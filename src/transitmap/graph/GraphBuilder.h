@@ -28,24 +28,57 @@ struct ShrdSegWrap {
   SharedSegment<double> s;
 };
 
+// tentative geometry of a node front, and the remaining length of its edge
+struct NodeFrontState {
+  util::geo::PolyLine<double> geom;
+  double len;
+};
+
 class GraphBuilder {
  public:
   GraphBuilder(const config::Config* cfg);
 
   void writeNodeFronts(shared::rendergraph::RenderGraph* g);
-  void expandOverlappinFronts(shared::rendergraph::RenderGraph* g);
+  // shrink overlapping node fronts until nothing overlaps anymore, returns
+  // the nodes whose fronts were shrunk, possibly more than once
+  std::vector<shared::linegraph::LineNode*> expandOverlappinFronts(
+      shared::rendergraph::RenderGraph* g);
+
+  // as above, but only the fronts of nds are checked initially
+  std::vector<shared::linegraph::LineNode*> expandOverlappinFronts(
+      shared::rendergraph::RenderGraph* g,
+      const std::vector<shared::linegraph::LineNode*>& nds);
   void dropOverlappingStations(shared::rendergraph::RenderGraph* g);
 
  private:
   const config::Config* _cfg;
 
-  std::set<shared::linegraph::NodeFront*> nodeGetOverlappingFronts(
+  // indices of the fronts of n which overlap another front, with the
+  // front geometries given in st
+  std::set<size_t> nodeGetOverlappingFronts(
       const shared::rendergraph::RenderGraph* g,
-      const shared::linegraph::LineNode* n) const;
+      const shared::linegraph::LineNode* n,
+      const std::vector<NodeFrontState>& st) const;
+
+  // the distance each front of n has to be shrunk by until no fronts
+  // overlap anymore, without changing the graph
+  std::vector<double> nodeFrontShrinks(
+      const shared::rendergraph::RenderGraph* g,
+      const shared::linegraph::LineNode* n, double step) const;
+
+  NodeFrontState shrunkFront(const shared::rendergraph::RenderGraph* g,
+                             const shared::linegraph::LineNode* n,
+                             const shared::linegraph::NodeFront& f,
+                             const util::geo::PolyLine<double>& edgeGeom,
+                             double s) const;
+
+  void shrinkFront(shared::rendergraph::RenderGraph* g,
+                   const shared::linegraph::LineNode* n,
+                   shared::linegraph::NodeFront* f, double s) const;
 
   bool nodeFrontsOverlap(const shared::rendergraph::RenderGraph* g,
-                         const shared::linegraph::NodeFront& a,
-                         const shared::linegraph::NodeFront& b,
+                         const util::geo::PolyLine<double>& a,
+                         const util::geo::PolyLine<double>& b,
                          double d) const;
 
   mutable std::set<const shared::linegraph::LineEdge*> _indEdges;
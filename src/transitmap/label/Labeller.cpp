@@ -2,6 +2,9 @@
 // Chair of Algorithms and Data Structures.
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
+#include <algorithm>
+#include <set>
+
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/label/Labeller.h"
 #include "util/geo/Geo.h"
@@ -16,22 +19,48 @@ using util::geo::MultiLine;
 using util::geo::PolyLine;
 
 // _____________________________________________________________________________
-Labeller::Labeller(const config::Config* cfg) : _cfg(cfg) {}
+Labeller::Labeller(const config::Config* cfg) : _maxLineDist(0), _cfg(cfg) {}
 
 // _____________________________________________________________________________
 void Labeller::label(const RenderGraph& g, bool notDeg2) {
+  buildCaches(g);
   labelStations(g, notDeg2);
   labelLines(g);
 }
 
 // _____________________________________________________________________________
-util::geo::MultiLine<double> Labeller::getStationLblBand(
-    const shared::linegraph::LineNode* n, double fontSize, uint8_t offset,
-    const RenderGraph& g) {
-  // TODO: the hull padding should be the same as in the renderer
-  auto statHull = g.getStopGeoms(n, _cfg->tightStations, 4);
+void Labeller::buildCaches(const RenderGraph& g) {
+  _maxLineDist = g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing);
+
+  std::vector<const shared::linegraph::LineNode*> statNds;
+  for (auto n : g.getNds()) {
+    if (n->pl().stops().size()) statNds.push_back(n);
+  }
+
+  std::vector<double> rads(statNds.size());
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < statNds.size(); i++) {
+    // TODO: the hull padding should be the same as in the renderer
+    auto statHull = g.getStopGeoms(statNds[i], _cfg->tightStations, 4);
+    rads[i] =
+        util::geo::getEnclosingRadius(*statNds[i]->pl().getGeom(), statHull);
+  }
+
+  _statRads.clear();
+  for (size_t i = 0; i < statNds.size(); i++) _statRads[statNds[i]] = rads[i];
+}
+
+// _____________________________________________________________________________
+double Labeller::getStatRad(const shared::linegraph::LineNode* n) const {
+  return _statRads.find(n)->second;
+}
 
-  double rad = util::geo::getEnclosingRadius(*n->pl().getGeom(), statHull);
+// _____________________________________________________________________________
+util::geo::MultiLine<double> Labeller::getStationLblBand(
+    const shared::linegraph::LineNode* n, double fontSize,
+    uint8_t offset) const {
+  double rad = getStatRad(n);
 
   // TODO: determine the label width based on the real font width. This is
   // nontrivial, as it requires the fonts to be rendered for non-monospaced
@@ -93,19 +122,33 @@ void Labeller::labelStations(const RenderGraph& g, bool notdeg2) {
 
     std::vector<StationLabel> cands;
 
+    std::vector<MultiLine<double>> bands(3);
     for (uint8_t offset = 0; offset < 3; offset++) {
-      for (size_t deg = 0; deg < 8; deg++) {
-        auto band = getStationLblBand(n, fontSize, offset, g);
-        band = util::geo::rotate(band, 45 * deg, *n->pl().getGeom());
+      bands[offset] = getStationLblBand(n, fontSize, offset);
+    }
+
+    // the candidates are evaluated in parallel against the labels placed so
+    // far, only the placement of the best candidate is sequential
+    std::vector<Overlaps> overlaps(3 * 8);
 
-        auto overlaps = getOverlaps(band, n, g);
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < 3 * 8; i++) {
+      auto band = util::geo::rotate(bands[i / 8], 45 * (i % 8),
+                                    *n->pl().getGeom());
+      overlaps[i] = getOverlaps(band, n, g);
+    }
+
+    for (uint8_t offset = 0; offset < 3; offset++) {
+      for (size_t deg = 0; deg < 8; deg++) {
+        const auto& ovl = overlaps[offset * 8 + deg];
 
-        if (overlaps.lineOverlaps + overlaps.statLabelOverlaps +
-                overlaps.statOverlaps >
-            0)
+        if (ovl.lineOverlaps + ovl.statLabelOverlaps + ovl.statOverlaps > 0)
           continue;
+
+        auto band =
+            util::geo::rotate(bands[offset], 45 * deg, *n->pl().getGeom());
         cands.push_back({PolyLine<double>(band[0]), band, fontSize,
-                         g.isTerminus(n), deg, offset, overlaps,
+                         g.isTerminus(n), deg, offset, ovl,
                          n->pl().stops().front()});
       }
     }
@@ -130,8 +173,7 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
   std::set<const shared::linegraph::LineNode*> procedNds{forNd};
 
   for (auto line : band) {
-    auto neighs = g.getNeighborEdges(
-        line, g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing));
+    auto neighs = g.getNeighborEdges(line, _maxLineDist);
     for (auto neigh : neighs) {
       if (proced.count(neigh)) continue;
 
@@ -148,10 +190,7 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
         if (nd->pl().stops().size() && !procedNds.count(nd)) {
           procedNds.insert(nd);
 
-          auto statHull = g.getStopGeoms(nd, _cfg->tightStations, 4);
-
-          double rad =
-              util::geo::getEnclosingRadius(*nd->pl().getGeom(), statHull);
+          double rad = getStatRad(nd);
 
           if (util::geo::dist(*nd->pl().getGeom(), band) <
               rad + (_cfg->lineWidth + _cfg->lineSpacing) / 2) {
@@ -163,12 +202,10 @@ Overlaps Labeller::getOverlaps(const util::geo::MultiLine<double>& band,
   }
 
   std::set<size_t> labelNeighs;
-  _statLblIdx.get(band,
-                  g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing),
-                  &labelNeighs);
+  _statLblIdx.get(band, _maxLineDist, &labelNeighs);
 
   for (auto id : labelNeighs) {
-    auto labelNeigh = _stationLabels[id];
+    const auto& labelNeigh = _stationLabels[id];
     if (util::geo::dist(labelNeigh.band, band) < 1) ret.statLabelOverlaps++;
   }
 
@@ -208,10 +245,8 @@ void Labeller::labelLines(const RenderGraph& g) {
 
           bool block = false;
 
-          for (auto neigh : g.getNeighborEdges(
-                   cand.getLine(),
-                   g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing) +
-                       fontSize * 4)) {
+          for (auto neigh : g.getNeighborEdges(cand.getLine(),
+                                               _maxLineDist + fontSize * 4)) {
             if (neigh == e) continue;
             if (util::geo::dist(cand.getLine(), *neigh->pl().getGeom()) <
                 (g.getTotalWidth(neigh) / 2) + (fontSize)) {
@@ -221,13 +256,11 @@ void Labeller::labelLines(const RenderGraph& g) {
           }
 
           std::set<size_t> labelNeighs;
-          _statLblIdx.get(
-              MultiLine<double>{cand.getLine()},
-              g.getMaxLineNum() * (_cfg->lineWidth + _cfg->lineSpacing),
-              &labelNeighs);
+          _statLblIdx.get(MultiLine<double>{cand.getLine()}, _maxLineDist,
+                          &labelNeighs);
 
           for (auto neighId : labelNeighs) {
-            auto neigh = _stationLabels[neighId];
+            const auto& neigh = _stationLabels[neighId];
             if (util::geo::dist(cand.getLine(), neigh.band) < (fontSize)) {
               block = true;
               break;
@@ -247,7 +280,7 @@ void Labeller::labelLines(const RenderGraph& g) {
           }
 
           for (auto neighLabelId : lineLabelNeighs) {
-            auto neighLabel = _lineLabels[neighLabelId];
+            const auto& neighLabel = _lineLabels[neighLabelId];
             if (neighLabel.lines == lines &&
                 util::geo::dist(cand.getLine(), neighLabel.geom.getLine()) <
                     20 * (_cfg->lineWidth + _cfg->lineSpacing)) {
@@ -5,6 +5,9 @@
 #ifndef TRANSITMAP_LABEL_LABELLER_H_
 #define TRANSITMAP_LABEL_LABELLER_H_
 
+#include <unordered_map>
+#include <vector>
+
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
@@ -98,8 +101,16 @@ class Labeller {
 
   StatLblIdx _statLblIdx;
 
+  // enclosing radius of the station hull of each station node, and the
+  // maximum width of the line bundles, both fixed for the graph
+  std::unordered_map<const shared::linegraph::LineNode*, double> _statRads;
+  double _maxLineDist;
+
   const config::Config* _cfg;
 
+  void buildCaches(const shared::rendergraph::RenderGraph& g);
+  double getStatRad(const shared::linegraph::LineNode* n) const;
+
   void labelStations(const shared::rendergraph::RenderGraph& g, bool notdeg2);
   void labelLines(const shared::rendergraph::RenderGraph& g);
 
@@ -108,8 +119,8 @@ class Labeller {
                        const shared::rendergraph::RenderGraph& g) const;
 
   util::geo::MultiLine<double> getStationLblBand(
-      const shared::linegraph::LineNode* n, double fontSize, uint8_t offset,
-      const shared::rendergraph::RenderGraph& g);
+      const shared::linegraph::LineNode* n, double fontSize,
+      uint8_t offset) const;
 };
 }  // namespace label
 }  // namespace transitmapper
@@ -0,0 +1,187 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifdef SQLITE3_FOUND
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+#include "transitmap/output/MbTilesArchive.h"
+
+using transitmapper::output::MbTilesArchive;
+
+// _____________________________________________________________________________
+MbTilesArchive::MbTilesArchive(const std::string& path, bool gzip)
+    : TileArchive(gzip),
+      _path(path),
+      _db(0),
+      _insMap(0),
+      _insImg(0),
+      _getImg(0) {
+  // an existing archive is replaced
+  remove(_path.c_str());
+
+  if (sqlite3_open(_path.c_str(), &_db) != SQLITE_OK) {
+    std::string err = sqlite3_errmsg(_db);
+    close();
+    throw std::runtime_error("Could not open " + _path + ": " + err);
+  }
+
+  // the archive is written once, a crash leaves an unusable file anyway
+  exec("PRAGMA synchronous=OFF");
+  exec("PRAGMA journal_mode=OFF");
+  exec("PRAGMA page_size=65536");
+
+  exec("CREATE TABLE metadata (name TEXT, value TEXT)");
+  exec(
+      "CREATE TABLE map (zoom_level INTEGER, tile_column INTEGER, tile_row "
+      "INTEGER, tile_id INTEGER)");
+  exec("CREATE TABLE images (tile_id INTEGER PRIMARY KEY, tile_data BLOB)");
+  exec(
+      "CREATE VIEW tiles AS SELECT map.zoom_level AS zoom_level, "
+      "map.tile_column AS tile_column, map.tile_row AS tile_row, "
+      "images.tile_data AS tile_data FROM map JOIN images ON "
+      "images.tile_id = map.tile_id");
+
+  exec("BEGIN");
+
+  check(sqlite3_prepare_v2(_db, "INSERT INTO map VALUES (?, ?, ?, ?)", -1,
+                           &_insMap, 0),
+        SQLITE_OK);
+  check(sqlite3_prepare_v2(_db, "INSERT INTO images VALUES (?, ?)", -1,
+                           &_insImg, 0),
+        SQLITE_OK);
+  check(sqlite3_prepare_v2(
+            _db, "SELECT tile_data FROM images WHERE tile_id = ?", -1,
+            &_getImg, 0),
+        SQLITE_OK);
+}
+
+// _____________________________________________________________________________
+MbTilesArchive::~MbTilesArchive() { close(); }
+
+// _____________________________________________________________________________
+bool MbTilesArchive::write(size_t z, size_t x, size_t y,
+                           const std::string& data) {
+  bool isNew = true;
+
+  // identical tiles (for example empty ones) reference the same image
+  auto& ids = _contents[hash(data)];
+  size_t id = _numContents;
+  for (size_t cand : ids) {
+    if (sameData(cand, data)) {
+      id = cand;
+      isNew = false;
+      break;
+    }
+  }
+
+  if (isNew) {
+    sqlite3_bind_int64(_insImg, 1, id);
+    sqlite3_bind_blob(_insImg, 2, data.data(), data.size(), SQLITE_STATIC);
+    check(sqlite3_step(_insImg), SQLITE_DONE);
+    sqlite3_reset(_insImg);
+    ids.push_back(id);
+  }
+
+  // MBTiles rows are counted from the south, as our y
+  sqlite3_bind_int64(_insMap, 1, z);
+  sqlite3_bind_int64(_insMap, 2, x);
+  sqlite3_bind_int64(_insMap, 3, y);
+  sqlite3_bind_int64(_insMap, 4, id);
+  check(sqlite3_step(_insMap), SQLITE_DONE);
+  sqlite3_reset(_insMap);
+
+  return isNew;
+}
+
+// _____________________________________________________________________________
+bool MbTilesArchive::sameData(size_t id, const std::string& data) {
+  sqlite3_bind_int64(_getImg, 1, id);
+  check(sqlite3_step(_getImg), SQLITE_ROW);
+
+  const char* blob =
+      static_cast<const char*>(sqlite3_column_blob(_getImg, 0));
+  size_t size = sqlite3_column_bytes(_getImg, 0);
+  bool ret = data.size() == size && data.compare(0, size, blob, size) == 0;
+
+  sqlite3_reset(_getImg);
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void MbTilesArchive::finish() {
+  exec("CREATE UNIQUE INDEX tile_index ON map (zoom_level, tile_column, "
+       "tile_row)");
+
+  std::stringstream bounds;
+  bounds << _bounds.getLowerLeft().getX() << ","
+         << _bounds.getLowerLeft().getY() << ","
+         << _bounds.getUpperRight().getX() << ","
+         << _bounds.getUpperRight().getY();
+
+  std::vector<std::pair<std::string, std::string>> meta = {
+      {"name", "transitmap"},
+      {"format", "pbf"},
+      {"type", "overlay"},
+      {"minzoom", std::to_string(_numTiles ? _minZoom : 0)},
+      {"maxzoom", std::to_string(_maxZoom)},
+      {"json", vectorLayersJson()}};
+
+  if (_numTiles) meta.push_back({"bounds", bounds.str()});
+
+  sqlite3_stmt* ins;
+  check(sqlite3_prepare_v2(_db, "INSERT INTO metadata VALUES (?, ?)", -1, &ins,
+                           0),
+        SQLITE_OK);
+  for (const auto& kv : meta) {
+    sqlite3_bind_text(ins, 1, kv.first.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(ins, 2, kv.second.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(ins);
+    sqlite3_reset(ins);
+    if (rc != SQLITE_DONE) {
+      sqlite3_finalize(ins);
+      check(rc, SQLITE_DONE);
+    }
+  }
+  sqlite3_finalize(ins);
+
+  exec("COMMIT");
+
+  close();
+}
+
+// _____________________________________________________________________________
+void MbTilesArchive::exec(const std::string& sql) {
+  char* err = 0;
+  if (sqlite3_exec(_db, sql.c_str(), 0, 0, &err) != SQLITE_OK) {
+    std::string msg = err ? err : "";
+    sqlite3_free(err);
+    throw std::runtime_error("Could not write to " + _path + ": " + msg);
+  }
+}
+
+// _____________________________________________________________________________
+void MbTilesArchive::check(int rc, int expected) {
+  if (rc != expected)
+    throw std::runtime_error("Could not write to " + _path + ": " +
+                             sqlite3_errmsg(_db));
+}
+
+// _____________________________________________________________________________
+void MbTilesArchive::close() {
+  sqlite3_finalize(_insMap);
+  sqlite3_finalize(_insImg);
+  sqlite3_finalize(_getImg);
+  _insMap = 0;
+  _insImg = 0;
+  _getImg = 0;
+
+  if (_db) sqlite3_close(_db);
+  _db = 0;
+}
+
+#endif
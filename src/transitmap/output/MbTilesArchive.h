@@ -0,0 +1,58 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_MBTILESARCHIVE_H_
+#define TRANSITMAP_OUTPUT_MBTILESARCHIVE_H_
+
+#ifdef SQLITE3_FOUND
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "transitmap/output/TileArchive.h"
+
+namespace transitmapper {
+namespace output {
+
+// MBTiles archive, a SQLite database. Identical tiles are stored once in the
+// images table and referenced from the map table, the tiles view joins both
+// as required by the MBTiles spec. All tiles are written in a single
+// transaction, the tile index is created on finish().
+class MbTilesArchive : public TileArchive {
+ public:
+  MbTilesArchive(const std::string& path, bool gzip);
+  virtual ~MbTilesArchive();
+
+  virtual void finish();
+
+ protected:
+  virtual bool write(size_t z, size_t x, size_t y, const std::string& data);
+
+ private:
+  std::string _path;
+  sqlite3* _db;
+  sqlite3_stmt* _insMap;
+  sqlite3_stmt* _insImg;
+  sqlite3_stmt* _getImg;
+
+  // content hash to the ids of the stored images with this hash
+  std::unordered_map<uint64_t, std::vector<size_t>> _contents;
+
+  bool sameData(size_t id, const std::string& data);
+
+  void exec(const std::string& sql);
+  void check(int rc, int expected);
+  void close();
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif
+
+#endif  // TRANSITMAP_OUTPUT_MBTILESARCHIVE_H_
@@ -8,14 +8,20 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <ostream>
+#include <set>
+#include <sstream>
+#include <unordered_set>
 
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/output/MvtRenderer.h"
 #include "transitmap/output/protobuf/vector_tile.pb.h"
+#include "util/Misc.h"
 #include "util/String.h"
 #include "util/geo/PolyLine.h"
 #include "util/log/Log.h"
@@ -27,6 +33,7 @@ using shared::rendergraph::RenderGraph;
 using transitmapper::label::Labeller;
 using transitmapper::output::InnerClique;
 using transitmapper::output::MvtRenderer;
+using transitmapper::output::MvtTagIndex;
 using util::geo::Box;
 using util::geo::DPoint;
 using util::geo::DPolygon;
@@ -54,13 +61,9 @@ const static double GRID2_W =
     (WEB_MERC_EXT * 2) / static_cast<double>(GRID2_SIZE);
 
 // _____________________________________________________________________________
-MvtRenderer::MvtRenderer(const config::Config* cfg, size_t zoom)
-    : _cfg(cfg), _zoom(zoom) {
-  _grid = new size_t[GRID_SIZE * GRID_SIZE];
-  for (size_t i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
-    _grid[i] = std::numeric_limits<uint32_t>::max();
-  }
-
+MvtRenderer::MvtRenderer(const config::Config* cfg, size_t zoom,
+                         TileArchive* archive)
+    : _cfg(cfg), _zoom(zoom), _archive(archive) {
   _grid2 = new size_t[GRID2_SIZE * GRID2_SIZE];
   for (size_t i = 0; i < GRID2_SIZE * GRID2_SIZE; i++) {
     _grid2[i] = std::numeric_limits<uint32_t>::max();
@@ -114,7 +117,7 @@ void MvtRenderer::outputNodes(const RenderGraph& outG) {
         params["component"] = util::toString(n->pl().getComponent());
 
       for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
-        addFeature({geom.getOuter(), "stations", params});
+        addFeature(geom.getOuter(), MVT_LAYER_STATIONS, params);
       }
     }
   }
@@ -132,12 +135,12 @@ void MvtRenderer::renderNodeFronts(const RenderGraph& outG) {
       params["lineCap"] = "round";
       params["width"] = "2";
 
-      addFeature({p.getLine(), "lines", params});
+      addFeature(p.getLine(), MVT_LAYER_LINES, params);
 
       DPoint a = p.getPointAt(.5).p;
 
-      addFeature(
-          {PolyLine<double>(*n->pl().getGeom(), a).getLine(), "lines", params});
+      addFeature(PolyLine<double>(*n->pl().getGeom(), a).getLine(),
+                 MVT_LAYER_LINES, params);
     }
   }
 }
@@ -360,7 +363,7 @@ void MvtRenderer::renderClique(const InnerClique& cc, const LineNode* n) {
         if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
           paramsOut["component"] = util::toString(n->pl().getComponent());
 
-        addFeature({pl.getLine(), "inner-connections", paramsOut});
+        addFeature(pl.getLine(), MVT_LAYER_INNER, paramsOut);
       }
 
       Params params;
@@ -374,7 +377,7 @@ void MvtRenderer::renderClique(const InnerClique& cc, const LineNode* n) {
       if (n->pl().getComponent() != std::numeric_limits<uint32_t>::max())
         params["component"] = util::toString(n->pl().getComponent());
 
-      addFeature({pl.getLine(), "inner-connections", params});
+      addFeature(pl.getLine(), MVT_LAYER_INNER, params);
     }
   }
 }
@@ -427,9 +430,9 @@ void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
 
     std::string css, oCss;
 
-    if (!lo.style.isNull()) {
-      css = lo.style.get().getCss();
-      oCss = lo.style.get().getOutlineCss();
+    if (lo.style) {
+      css = lo.style->getCss();
+      oCss = lo.style->getOutlineCss();
     }
 
     if (_cfg->outlineWidth > 0) {
@@ -445,7 +448,7 @@ void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
       if (e->pl().getComponent() != std::numeric_limits<uint32_t>::max())
         paramsOut["component"] = util::toString(e->pl().getComponent());
 
-      addFeature({p.getLine(), "lines", paramsOut});
+      addFeature(p.getLine(), MVT_LAYER_LINES, paramsOut);
     }
 
     Params params;
@@ -459,14 +462,33 @@ void MvtRenderer::renderEdgeTripGeom(const RenderGraph& outG,
     if (e->pl().getComponent() != std::numeric_limits<uint32_t>::max())
       params["component"] = util::toString(e->pl().getComponent());
 
-    addFeature({p.getLine(), "lines", params});
+    addFeature(p.getLine(), MVT_LAYER_LINES, params);
 
     o -= offsetStep;
   }
 }
 
 // _____________________________________________________________________________
-void MvtRenderer::addFeature(const MvtLineFeature& feature) {
+void MvtRenderer::addFeature(const util::geo::Line<double>& line,
+                             MvtLayer layer, const Params& params) {
+  if (line.size() < 2) return;
+
+  // skip zero-width geometries
+  if (layer != MVT_LAYER_STATIONS) {
+    auto w = params.find("width");
+    if (w != params.end() && w->second == "0") return;
+  }
+
+  MvtLineFeature feature{line, layer, {}};
+  feature.tags.reserve(params.size());
+
+  // keys and values are interned once, tiles only map the global ids to
+  // their local indices
+  for (const auto& kv : params) {
+    feature.tags.push_back({internTag(kv.first, &_keys, &_keyIds),
+                            internTag(kv.second, &_vals, &_valIds)});
+  }
+
   double w =
       (_cfg->lineWidth + _cfg->lineSpacing + 2 * _cfg->outlineWidth) * _res;
   const auto& box = util::geo::pad(util::geo::getBoundingBox(feature.line), w);
@@ -486,12 +508,13 @@ void MvtRenderer::addFeature(const MvtLineFeature& feature) {
   for (size_t x = swX; x <= neX && x < GRID_SIZE; x++) {
     for (size_t y = swY; y <= neY && y < GRID_SIZE; y++) {
       if (util::geo::intersects(feature.line, getBox(GRID_ZOOM, x, y))) {
-        if (_grid[x * GRID_SIZE + y] == std::numeric_limits<uint32_t>::max()) {
-          _grid[x * GRID_SIZE + y] = _lines.size();
+        auto cell = _grid.find(x * GRID_SIZE + y);
+        if (cell == _grid.end()) {
+          cell = _grid.insert({x * GRID_SIZE + y, _lines.size()}).first;
           _cells.push_back({x, y});
           _lines.push_back({});
         }
-        _lines[_grid[x * GRID_SIZE + y]].push_back(_lineFeatures.size());
+        _lines[cell->second].push_back(_lineFeatures.size());
       }
     }
   }
@@ -520,6 +543,47 @@ void MvtRenderer::addFeature(const MvtLineFeature& feature) {
   _lineFeatures.push_back(feature);
 }
 
+// _____________________________________________________________________________
+uint32_t MvtRenderer::internTag(
+    const std::string& tag, std::vector<std::string>* tags,
+    std::unordered_map<std::string, uint32_t>* ids) {
+  auto i = ids->find(tag);
+  if (i != ids->end()) return i->second;
+
+  ids->insert({tag, tags->size()});
+  tags->push_back(tag);
+  return tags->size() - 1;
+}
+
+// _____________________________________________________________________________
+void MvtTagIndex::reset(size_t n) {
+  if (local.size() != n) {
+    local.assign(n, std::numeric_limits<uint32_t>::max());
+  } else {
+    for (uint32_t id : used) local[id] = std::numeric_limits<uint32_t>::max();
+  }
+  used.clear();
+}
+
+// _____________________________________________________________________________
+uint32_t MvtRenderer::tagIdx(uint32_t id, MvtTagIndex* idx,
+                             vector_tile::Tile_Layer* layer, bool key) const {
+  if (idx->local[id] != std::numeric_limits<uint32_t>::max())
+    return idx->local[id];
+
+  idx->used.push_back(id);
+
+  if (key) {
+    *layer->add_keys() = _keys[id];
+    idx->local[id] = layer->keys_size() - 1;
+  } else {
+    layer->add_values()->set_string_value(_vals[id]);
+    idx->local[id] = layer->values_size() - 1;
+  }
+
+  return idx->local[id];
+}
+
 // _____________________________________________________________________________
 uint32_t MvtRenderer::gridC(double c) const {
   return (WEB_MERC_EXT + c) / GRID_W;
@@ -535,17 +599,11 @@ Box<double> MvtRenderer::getBox(size_t z, size_t x, size_t y) const {
 }
 
 // _____________________________________________________________________________
-void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
-                               size_t x, size_t y,
-                               vector_tile::Tile_Layer* layer, Params params,
-                               std::map<std::string, size_t>& keys,
-                               std::map<std::string, size_t>& vals) {
-  if (l.size() < 2) return;
-
-  // skip zero-width geometries
-  if ((layer->name() == "lines" || layer->name() == "inner-connections") &&
-      params.count("width") && params.find("width")->second == "0")
-    return;
+void MvtRenderer::printFeature(const MvtLineFeature& f, size_t z, size_t x,
+                               size_t y, vector_tile::Tile_Layer* layer,
+                               MvtTagIndex* keys, MvtTagIndex* vals) const {
+  const auto& l = f.line;
+  bool polygon = f.layer == MVT_LAYER_STATIONS;
 
   double tw = (WEB_MERC_EXT * 2.0) / static_cast<double>(1 << z);
 
@@ -558,7 +616,7 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
   // pad!
   auto box = util::geo::pad(getBox(z, x, y), 50 * (tw / TILE_RES));
 
-  if (layer->name() == "stations") {
+  if (polygon) {
     croppedLines.push_back(l);
   } else {
     croppedLines.push_back({});
@@ -589,32 +647,14 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
 
     auto feature = layer->add_features();
 
-    for (const auto& kv : params) {
-      auto kit = keys.find(kv.first);
-      auto vit = vals.find(kv.second);
-
-      if (kit != keys.end()) {
-        feature->add_tags(kit->second);
-      } else {
-        auto k = layer->add_keys();
-        *k = kv.first;
-        feature->add_tags(layer->keys_size() - 1);
-        keys[kv.first] = layer->keys_size() - 1;
-      }
-
-      if (vit != vals.end()) {
-        feature->add_tags(vit->second);
-      } else {
-        auto k = layer->add_values();
-        k->set_string_value(kv.second);
-        feature->add_tags(layer->values_size() - 1);
-        vals[kv.second] = layer->values_size() - 1;
-      }
+    for (const auto& kv : f.tags) {
+      feature->add_tags(tagIdx(kv.first, keys, layer, true));
+      feature->add_tags(tagIdx(kv.second, vals, layer, false));
     }
 
     feature->set_id(1);
 
-    if (layer->name() == "stations") {
+    if (polygon) {
       feature->set_type(vector_tile::Tile_GeomType_POLYGON);
     } else {
       feature->set_type(vector_tile::Tile_GeomType_LINESTRING);
@@ -641,7 +681,7 @@ void MvtRenderer::printFeature(const util::geo::Line<double>& l, size_t z,
       feature->add_geometry((dy << 1) ^ (dy >> 31));
     }
 
-    if (layer->name() == "stations") {
+    if (polygon) {
       // close path
       feature->add_geometry((7 & 0x7) | (1 << 3));
     }
@@ -660,210 +700,271 @@ std::string MvtRenderer::getLineClass(const std::string& id) const {
 // _____________________________________________________________________________
 void MvtRenderer::serializeTile(size_t x, size_t y, size_t z,
                                 vector_tile::Tile* tile) {
-  std::stringstream ss;
+  if (_archive) {
+    std::string a;
+    tile->SerializeToString(&a);
+
+    // compression is done in parallel, the archive itself is written
+    // sequentially
+    a = _archive->encode(a);
+
+    std::string err;
+#pragma omp critical(tileArchive)
+    {
+      try {
+        _archive->add(z, x, y, a);
+      } catch (const std::exception& e) {
+        err = e.what();
+      }
+    }
 
-  ss << _cfg->mvtPath << "/";
+    if (!err.empty()) throw std::runtime_error(err);
+    return;
+  }
 
-  ss << z;
-  int err = mkdir(ss.str().c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  // the directories have already been created in writeTiles()
+  std::stringstream ss;
+  ss << _cfg->mvtPath << "/" << z << "/" << x << "/" << ((1 << z) - 1 - y)
+     << ".mvt";
 
-  if (err == -1) {
-    if (errno != EEXIST) {
-      throw std::runtime_error("Could not create output directory " + ss.str());
-    }
+  std::fstream fo(ss.str().c_str(),
+                  std::ios::out | std::ios::trunc | std::ios::binary);
+
+  if (!fo.is_open()) {
+    throw std::runtime_error("Could not open " + ss.str());
   }
 
-  ss << "/" << x;
-  err = mkdir(ss.str().c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  std::string a;
+
+  tile->SerializeToString(&a);
+
+  fo.write(a.data(), a.size());
+}
+
+// _____________________________________________________________________________
+void MvtRenderer::mkTileDir(const std::string& path) const {
+  int err = mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
   if (err == -1) {
     if (errno != EEXIST) {
-      throw std::runtime_error("Could not create output directory " + ss.str());
+      throw std::runtime_error("Could not create output directory " + path);
     }
   }
+}
 
-  ss << "/" << ((1 << z) - 1 - y) << ".mvt";
+// _____________________________________________________________________________
+void MvtRenderer::encodeTile(size_t x, size_t y, size_t z,
+                             const std::vector<MvtLineFeature>& pool,
+                             const std::vector<size_t>& feats, bool filter,
+                             vector_tile::Tile* tile, MvtTagIndex* keys,
+                             MvtTagIndex* vals) const {
+  static const char* names[MVT_NUM_LAYERS] = {"inner-connections", "lines",
+                                              "stations"};
+  vector_tile::Tile_Layer* layers[MVT_NUM_LAYERS];
+
+  for (size_t i = 0; i < MVT_NUM_LAYERS; i++) {
+    layers[i] = tile->add_layers();
+    layers[i]->set_version(2);
+    layers[i]->set_name(names[i]);
+    layers[i]->set_extent(TILE_RES);
+    keys[i].reset(_keys.size());
+    vals[i].reset(_vals.size());
+  }
 
-  std::fstream fo(ss.str().c_str(),
-                  std::ios::out | std::ios::trunc | std::ios::binary);
+  for (const size_t lid : feats) {
+    const auto& l = pool[lid];
+    if (filter && !util::geo::intersects(l.line, getBox(z, x, y))) continue;
 
-  if (!fo.is_open()) {
-    throw std::runtime_error("Could not open " + ss.str());
+    printFeature(l, z, x, y, layers[l.layer], &keys[l.layer],
+                 &vals[l.layer]);
   }
+}
 
-  std::string a;
+// _____________________________________________________________________________
+void MvtRenderer::generalize(size_t z) {
+  size_t n = 1 << z;
+  double tw = (WEB_MERC_EXT * 2.0) / static_cast<double>(n);
+
+  // size of a single pixel on this zoom level
+  double px = tw / TILE_RES;
+
+  _genFeatures.clear();
+  _genTiles.assign(n * n, {});
+
+  // features which are identical on the pixel grid, for example the same
+  // line on parallel edges, are only written once
+  std::unordered_set<std::string> seen;
+
+  for (const auto& f : _lineFeatures) {
+    if (f.line.size() < 2) continue;
+
+    // drop sub-pixel features
+    const auto& box = util::geo::getBoundingBox(f.line);
+    if (box.getUpperRight().getX() - box.getLowerLeft().getX() < px &&
+        box.getUpperRight().getY() - box.getLowerLeft().getY() < px)
+      continue;
+
+    MvtLineFeature gen{{}, f.layer, f.tags};
+
+    // snap the simplified geometry to the pixel grid
+    for (const auto& p : util::geo::simplify(f.line, px)) {
+      DPoint snapped(std::round(p.getX() / px) * px,
+                     std::round(p.getY() / px) * px);
+      if (gen.line.size() && gen.line.back().getX() == snapped.getX() &&
+          gen.line.back().getY() == snapped.getY())
+        continue;
+      gen.line.push_back(snapped);
+    }
 
-  tile->SerializeToString(&a);
+    if (gen.line.size() < 2) continue;
+
+    std::string key(1, gen.layer);
+    key.append(reinterpret_cast<const char*>(gen.tags.data()),
+               gen.tags.size() * sizeof(gen.tags[0]));
+    key += '\0';
+    for (const auto& p : gen.line) {
+      int64_t c[2] = {static_cast<int64_t>(std::round(p.getX() / px)),
+                      static_cast<int64_t>(std::round(p.getY() / px))};
+      key.append(reinterpret_cast<const char*>(c), sizeof(c));
+    }
+
+    if (!seen.insert(key).second) continue;
+
+    // add to all tiles the feature may be rendered into, with the padding
+    // used for cropping in printFeature()
+    const auto& gbox =
+        util::geo::pad(util::geo::getBoundingBox(gen.line), 50 * px);
+
+    size_t swX = tileC(gbox.getLowerLeft().getX(), tw, n);
+    size_t swY = tileC(gbox.getLowerLeft().getY(), tw, n);
+    size_t neX = tileC(gbox.getUpperRight().getX(), tw, n);
+    size_t neY = tileC(gbox.getUpperRight().getY(), tw, n);
 
-  fo << a;
+    for (size_t x = swX; x <= neX; x++) {
+      for (size_t y = swY; y <= neY; y++) {
+        _genTiles[x * n + y].push_back(_genFeatures.size());
+      }
+    }
+
+    _genFeatures.push_back(gen);
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Generalized " << _lineFeatures.size()
+                          << " features to " << _genFeatures.size()
+                          << " for zoom " << z;
+}
+
+// _____________________________________________________________________________
+size_t MvtRenderer::tileC(double c, double tw, size_t n) const {
+  double t = (WEB_MERC_EXT + c) / tw;
+  if (t < 0) return 0;
+  if (t >= n) return n - 1;
+  return t;
 }
 
 // _____________________________________________________________________________
 void MvtRenderer::writeTiles(size_t z) {
+  T_START(tiles);
+
+  // tiles to write, with the index of the grid cell holding their candidate
+  // features
+  std::vector<MvtTile> tiles;
+
   if (z >= GRID_ZOOM) {
-    for (auto cell : _cells) {
-      auto cx = cell.first;
-      auto cy = cell.second;
+    // _lines holds the features of _cells[i] at position i
+    for (size_t i = 0; i < _cells.size(); i++) {
+      auto cx = _cells[i].first;
+      auto cy = _cells[i].second;
 
       for (size_t ccx = (cx << (z - GRID_ZOOM));
            ccx < ((cx + 1) << (z - GRID_ZOOM)); ccx++) {
         for (size_t ccy = (cy << (z - GRID_ZOOM));
              ccy < ((cy + 1) << (z - GRID_ZOOM)); ccy++) {
-          vector_tile::Tile tile;
-
-          auto layerInner = tile.add_layers();
-          layerInner->set_version(2);
-          layerInner->set_name("inner-connections");
-          layerInner->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysInner, valsInner;
-
-          auto layerLines = tile.add_layers();
-          layerLines->set_version(2);
-          layerLines->set_name("lines");
-          layerLines->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysLines, valsLines;
-
-          auto layerStations = tile.add_layers();
-          layerStations->set_version(2);
-          layerStations->set_name("stations");
-          layerStations->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysStations, valsStations;
-
-          for (const size_t lid : _lines[_grid[cx * GRID_SIZE + cy]]) {
-            const auto& l = _lineFeatures[lid];
-            if (z == GRID_ZOOM ||
-                util::geo::intersects(l.line, getBox(z, ccx, ccy))) {
-              if (l.layer == "lines")
-                printFeature(l.line, z, ccx, ccy, layerLines, l.params,
-                             keysLines, valsLines);
-              if (l.layer == "inner-connections")
-                printFeature(l.line, z, ccx, ccy, layerInner, l.params,
-                             keysInner, valsInner);
-              if (l.layer == "stations")
-                printFeature(l.line, z, ccx, ccy, layerStations, l.params,
-                             keysStations, valsStations);
-            }
-          }
-
-          serializeTile(ccx, ccy, z, &tile);
+          tiles.push_back({ccx, ccy, i});
         }
       }
     }
   } else if (z >= GRID2_ZOOM) {
-    for (auto cell : _cells2) {
-      auto cx = cell.first;
-      auto cy = cell.second;
+    for (size_t i = 0; i < _cells2.size(); i++) {
+      auto cx = _cells2[i].first;
+      auto cy = _cells2[i].second;
 
       for (size_t ccx = (cx << (z - GRID2_ZOOM));
            ccx < ((cx + 1) << (z - GRID2_ZOOM)); ccx++) {
         for (size_t ccy = (cy << (z - GRID2_ZOOM));
              ccy < ((cy + 1) << (z - GRID2_ZOOM)); ccy++) {
-          vector_tile::Tile tile;
-
-          auto layerInner = tile.add_layers();
-          layerInner->set_version(2);
-          layerInner->set_name("inner-connections");
-          layerInner->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysInner, valsInner;
-
-          auto layerLines = tile.add_layers();
-          layerLines->set_version(2);
-          layerLines->set_name("lines");
-          layerLines->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysLines, valsLines;
-
-          auto layerStations = tile.add_layers();
-          layerStations->set_version(2);
-          layerStations->set_name("stations");
-          layerStations->set_extent(TILE_RES);
-          std::map<std::string, size_t> keysStations, valsStations;
-
-          for (const size_t lid : _lines2[_grid2[cx * GRID2_SIZE + cy]]) {
-            const auto& l = _lineFeatures[lid];
-            if (z == GRID2_ZOOM ||
-                util::geo::intersects(l.line, getBox(z, ccx, ccy))) {
-              if (l.layer == "lines")
-                printFeature(l.line, z, ccx, ccy, layerLines, l.params,
-                             keysLines, valsLines);
-              if (l.layer == "inner-connections")
-                printFeature(l.line, z, ccx, ccy, layerInner, l.params,
-                             keysInner, valsInner);
-              if (l.layer == "stations")
-                printFeature(l.line, z, ccx, ccy, layerStations, l.params,
-                             keysStations, valsStations);
-            }
-          }
-
-          serializeTile(ccx, ccy, z, &tile);
+          tiles.push_back({ccx, ccy, _grid2[cx * GRID2_SIZE + cy]});
         }
       }
     }
   } else {
+    // low zoom tiles cover large parts of the network, they are encoded from
+    // generalized geometries
+    generalize(z);
+
     for (size_t cx = 0; cx < static_cast<size_t>(1 << z); cx++) {
       for (size_t cy = 0; cy < static_cast<size_t>(1 << z); cy++) {
-        vector_tile::Tile tile;
-
-        auto layerInner = tile.add_layers();
-        layerInner->set_version(2);
-        layerInner->set_name("inner-connections");
-        layerInner->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysInner, valsInner;
-
-        auto layerLines = tile.add_layers();
-        layerLines->set_version(2);
-        layerLines->set_name("lines");
-        layerLines->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysLines, valsLines;
-
-        auto layerStations = tile.add_layers();
-        layerStations->set_version(2);
-        layerStations->set_name("stations");
-        layerStations->set_extent(TILE_RES);
-        std::map<std::string, size_t> keysStations, valsStations;
-
-        std::vector<size_t> objects;
-
-        if (z == 0) {
-          for (size_t i = 0; i < _lineFeatures.size(); i++) {
-            objects.push_back(i);
-          }
-        } else {
-          for (size_t ccx = (cx << (GRID2_ZOOM - z));
-               ccx < ((cx + 1) << (GRID2_ZOOM - z)); ccx++) {
-            for (size_t ccy = (cy << (GRID2_ZOOM - z));
-                 ccy < ((cy + 1) << (GRID2_ZOOM - z)); ccy++) {
-              if (_grid2[ccx * GRID2_SIZE + ccy] ==
-                  std::numeric_limits<uint32_t>::max())
-                continue;
-
-              const auto& lines = _lines2[_grid2[ccx * GRID2_SIZE + ccy]];
-              objects.insert(objects.end(), lines.begin(), lines.end());
-            }
-          }
-
-          std::sort(objects.begin(), objects.end());
-        }
+        tiles.push_back({cx, cy, cx * (1 << z) + cy});
+      }
+    }
+  }
 
-        for (size_t i = 0; i < objects.size(); i++) {
-          if (i > 0 && objects[i] == objects[i - 1]) continue;
+  // create the output directories once, before the tiles are written
+  if (!_archive) {
+    std::stringstream ss;
+    ss << _cfg->mvtPath << "/" << z;
+    mkTileDir(ss.str());
 
-          const auto& l = _lineFeatures[objects[i]];
+    std::set<size_t> cols;
+    for (const auto& t : tiles) cols.insert(t.x);
+    for (size_t x : cols) mkTileDir(ss.str() + "/" + std::to_string(x));
+  }
 
-          if (l.layer == "lines")
-            printFeature(l.line, z, cx, cy, layerLines, l.params, keysLines,
-                         valsLines);
-          if (l.layer == "inner-connections")
-            printFeature(l.line, z, cx, cy, layerInner, l.params, keysInner,
-                         valsInner);
-          if (l.layer == "stations")
-            printFeature(l.line, z, cx, cy, layerStations, l.params,
-                         keysStations, valsStations);
+  // tiles are independent, encode and write them in parallel
+  std::string err;
+
+#pragma omp parallel
+  {
+    // reused for all tiles of this thread, cleared messages keep their
+    // allocated memory
+    vector_tile::Tile tile;
+    MvtTagIndex keys[MVT_NUM_LAYERS], vals[MVT_NUM_LAYERS];
+
+#pragma omp for schedule(dynamic)
+    for (size_t i = 0; i < tiles.size(); i++) {
+      const auto& t = tiles[i];
+      tile.Clear();
+
+      try {
+        if (z >= GRID_ZOOM) {
+          encodeTile(t.x, t.y, z, _lineFeatures, _lines[t.cell],
+                     z != GRID_ZOOM, &tile, keys, vals);
+        } else if (z >= GRID2_ZOOM) {
+          encodeTile(t.x, t.y, z, _lineFeatures, _lines2[t.cell],
+                     z != GRID2_ZOOM, &tile, keys, vals);
+        } else {
+          encodeTile(t.x, t.y, z, _genFeatures, _genTiles[t.cell], false,
+                     &tile, keys, vals);
         }
 
-        serializeTile(cx, cy, z, &tile);
+        serializeTile(t.x, t.y, z, &tile);
+      } catch (const std::exception& e) {
+#pragma omp critical
+        err = e.what();
       }
     }
   }
+
+  if (!err.empty()) throw std::runtime_error(err);
+
+  double took = T_STOP(tiles);
+
+  if (_cfg->writeStats) {
+    LOGTO(INFO, std::cerr) << "Wrote " << tiles.size() << " tiles for zoom "
+                           << z << " in " << took << "ms ("
+                           << (took > 0 ? tiles.size() / (took / 1000.0) : 0)
+                           << " tiles/s)";
+  }
 }
 
 #endif
@@ -7,9 +7,12 @@
 
 #ifdef PROTOBUF_FOUND
 
+#include <stdint.h>
+
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Renderer.h"
@@ -17,6 +20,7 @@
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/label/Labeller.h"
+#include "transitmap/output/TileArchive.h"
 #include "transitmap/output/protobuf/vector_tile.pb.h"
 #include "util/geo/Geo.h"
 #include "util/geo/PolyLine.h"
@@ -27,19 +31,42 @@ using util::Nullable;
 namespace transitmapper {
 namespace output {
 
+enum MvtLayer : uint8_t {
+  MVT_LAYER_INNER = 0,
+  MVT_LAYER_LINES = 1,
+  MVT_LAYER_STATIONS = 2
+};
+
+const static size_t MVT_NUM_LAYERS = 3;
+
 struct MvtLineFeature {
   util::geo::Line<double> line;
-  std::string layer;
-  Params params;
+  MvtLayer layer;
+  // pairs of global key and value ids
+  std::vector<std::pair<uint32_t, uint32_t>> tags;
+};
+
+// maps global key or value ids to their index in a single tile layer, only
+// the used entries are reset between tiles
+struct MvtTagIndex {
+  std::vector<uint32_t> local;
+  std::vector<uint32_t> used;
+
+  void reset(size_t n);
+};
+
+struct MvtTile {
+  size_t x, y;
+  // index of the grid cell holding the candidate features
+  size_t cell;
 };
 
 class MvtRenderer : public Renderer {
  public:
-  MvtRenderer(const config::Config* cfg, size_t zoom);
-  virtual ~MvtRenderer() {
-    delete[] _grid;
-    delete[] _grid2;
-  };
+  // if archive is not null, tiles are added to it instead of being written
+  // to separate files
+  MvtRenderer(const config::Config* cfg, size_t zoom, TileArchive* archive);
+  virtual ~MvtRenderer() { delete[] _grid2; };
 
   virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
 
@@ -47,34 +74,67 @@ class MvtRenderer : public Renderer {
 
   void serializeTile(size_t x, size_t y, size_t z, vector_tile::Tile* l);
 
-  void printFeature(const util::geo::Line<double>& l, size_t z, size_t x,
-                    size_t y, vector_tile::Tile_Layer* layer, Params params,
-                    std::map<std::string, size_t>& keys,
-                    std::map<std::string, size_t>& vals);
+  // encode the features feats from pool into tile x, y on zoom z. If filter
+  // is set, features not intersecting the tile are skipped. keys and vals
+  // hold one tag index per layer.
+  void encodeTile(size_t x, size_t y, size_t z,
+                  const std::vector<MvtLineFeature>& pool,
+                  const std::vector<size_t>& feats, bool filter,
+                  vector_tile::Tile* tile, MvtTagIndex* keys,
+                  MvtTagIndex* vals) const;
+
+  void printFeature(const MvtLineFeature& f, size_t z, size_t x, size_t y,
+                    vector_tile::Tile_Layer* layer, MvtTagIndex* keys,
+                    MvtTagIndex* vals) const;
 
  private:
   const config::Config* _cfg;
   size_t _zoom;
   double _res;
 
-  // tile grid
-  uint64_t* _grid;
+  TileArchive* _archive;
+
+  // tile grid, sparse on GRID_ZOOM as only a tiny fraction of the cells is
+  // occupied, maps the cell x * GRID_SIZE + y to its index in _lines
+  std::unordered_map<uint64_t, size_t> _grid;
   uint64_t* _grid2;
 
   std::vector<MvtLineFeature> _lineFeatures;
 
+  // interned feature keys and values
+  std::vector<std::string> _keys;
+  std::vector<std::string> _vals;
+  std::unordered_map<std::string, uint32_t> _keyIds;
+  std::unordered_map<std::string, uint32_t> _valIds;
+
   std::vector<std::vector<size_t>> _lines;
   std::vector<std::pair<uint32_t, uint32_t>> _cells;
 
   std::vector<std::vector<size_t>> _lines2;
   std::vector<std::pair<uint32_t, uint32_t>> _cells2;
 
+  // generalized features for zoom levels below GRID2_ZOOM, and the features
+  // of each tile x * 2^z + y
+  std::vector<MvtLineFeature> _genFeatures;
+  std::vector<std::vector<size_t>> _genTiles;
+
   mutable std::map<std::string, int> lineClassIds;
   mutable int lineClassId = 0;
 
   util::geo::Box<double> getBox(size_t z, size_t x, size_t y) const;
   uint32_t gridC(double c) const;
-  void addFeature(const MvtLineFeature& featuer);
+  void mkTileDir(const std::string& path) const;
+  size_t tileC(double c, double tw, size_t n) const;
+
+  // build the generalized features for low zoom level z
+  void generalize(size_t z);
+  void addFeature(const util::geo::Line<double>& line, MvtLayer layer,
+                  const Params& params);
+
+  uint32_t internTag(const std::string& tag, std::vector<std::string>* tags,
+                     std::unordered_map<std::string, uint32_t>* ids);
+  uint32_t tagIdx(uint32_t id, MvtTagIndex* idx,
+                  vector_tile::Tile_Layer* layer, bool key) const;
 
   void outputNodes(const shared::rendergraph::RenderGraph& outputGraph);
   void outputEdges(const shared::rendergraph::RenderGraph& outputGraph);
@@ -0,0 +1,269 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "transitmap/output/PmTilesArchive.h"
+
+using transitmapper::output::PmTilesArchive;
+
+static const size_t HEADER_SIZE = 127;
+
+// the header and the root directory must fit into the first 16 KiB, tile
+// data starts right after
+static const uint64_t DATA_OFF = 16384;
+
+// compression types
+static const uint8_t COMPR_NONE = 1;
+static const uint8_t COMPR_GZIP = 2;
+
+static const uint8_t TILE_TYPE_MVT = 1;
+
+// _____________________________________________________________________________
+PmTilesArchive::PmTilesArchive(const std::string& path, bool gzip)
+    : TileArchive(gzip), _path(path), _dataLen(0) {
+  _f.open(_path.c_str(), std::ios::in | std::ios::out | std::ios::trunc |
+                             std::ios::binary);
+
+  if (!_f.is_open()) throw std::runtime_error("Could not open " + _path);
+
+  // reserve the space for the header and the root directory
+  std::string reserved(DATA_OFF, 0);
+  _f.write(reserved.data(), reserved.size());
+}
+
+// _____________________________________________________________________________
+PmTilesArchive::~PmTilesArchive() {
+  // finish() closes the file, an archive still open at this point was
+  // abandoned and only holds a zeroed header
+  if (_f.is_open()) {
+    _f.close();
+    std::remove(_path.c_str());
+  }
+}
+
+// _____________________________________________________________________________
+bool PmTilesArchive::write(size_t z, size_t x, size_t y,
+                           const std::string& data) {
+  Entry e{tileId(z, x, (1 << z) - 1 - y), 0, static_cast<uint32_t>(data.size()),
+          1};
+
+  // identical tiles (for example empty ones) point to the same data
+  uint64_t h = hash(data);
+  auto range = _contents.equal_range(h);
+  for (auto it = range.first; it != range.second; it++) {
+    if (sameData(it->second, data)) {
+      e.offset = it->second.offset;
+      _entries.push_back(e);
+      return false;
+    }
+  }
+
+  e.offset = _dataLen;
+
+  _f.seekp(DATA_OFF + _dataLen);
+  _f.write(data.data(), data.size());
+  if (!_f) throw std::runtime_error("Could not write to " + _path);
+
+  _dataLen += data.size();
+  _contents.insert({h, e});
+  _entries.push_back(e);
+
+  return true;
+}
+
+// _____________________________________________________________________________
+bool PmTilesArchive::sameData(const Entry& e, const std::string& data) {
+  if (e.length != data.size()) return false;
+
+  std::string stored(e.length, 0);
+  _f.seekg(DATA_OFF + e.offset);
+  _f.read(&stored[0], e.length);
+  if (!_f) throw std::runtime_error("Could not read from " + _path);
+
+  return stored == data;
+}
+
+// _____________________________________________________________________________
+void PmTilesArchive::finish() {
+  std::sort(_entries.begin(), _entries.end(),
+            [](const Entry& a, const Entry& b) { return a.tileId < b.tileId; });
+
+  // consecutive tiles with the same data are merged into runs
+  std::vector<Entry> entries;
+  for (const auto& e : _entries) {
+    if (entries.size() && entries.back().offset == e.offset &&
+        entries.back().tileId + entries.back().runLength == e.tileId) {
+      entries.back().runLength++;
+      continue;
+    }
+    entries.push_back(e);
+  }
+
+  std::string root, leaves;
+  serializeDirs(entries, DATA_OFF - HEADER_SIZE, &root, &leaves);
+
+  std::string meta = vectorLayersJson();
+
+  uint64_t metaOff = DATA_OFF + _dataLen;
+  uint64_t leavesOff = metaOff + meta.size();
+
+  _f.seekp(metaOff);
+  _f.write(meta.data(), meta.size());
+  _f.write(leaves.data(), leaves.size());
+
+  std::string h = "PMTiles";
+  h += static_cast<char>(3);
+  writeLe(HEADER_SIZE, 8, &h);
+  writeLe(root.size(), 8, &h);
+  writeLe(metaOff, 8, &h);
+  writeLe(meta.size(), 8, &h);
+  writeLe(leavesOff, 8, &h);
+  writeLe(leaves.size(), 8, &h);
+  writeLe(DATA_OFF, 8, &h);
+  writeLe(_dataLen, 8, &h);
+  writeLe(_numTiles, 8, &h);
+  writeLe(entries.size(), 8, &h);
+  writeLe(_numContents, 8, &h);
+
+  // tile data is written in the order the tiles were added, not clustered
+  writeLe(0, 1, &h);
+  writeLe(COMPR_NONE, 1, &h);
+  writeLe(_gzip ? COMPR_GZIP : COMPR_NONE, 1, &h);
+  writeLe(TILE_TYPE_MVT, 1, &h);
+
+  size_t minZoom = _numTiles ? _minZoom : 0;
+  writeLe(minZoom, 1, &h);
+  writeLe(_maxZoom, 1, &h);
+
+  // bounds and center as signed 32 bit integers, in 10^-7 degrees
+  const auto& ll = _bounds.getLowerLeft();
+  const auto& ur = _bounds.getUpperRight();
+  if (_numTiles == 0) {
+    writeLe(0, 16, &h);
+  } else {
+    writeLe(static_cast<uint32_t>(static_cast<int32_t>(ll.getX() * 1e7)), 4,
+            &h);
+    writeLe(static_cast<uint32_t>(static_cast<int32_t>(ll.getY() * 1e7)), 4,
+            &h);
+    writeLe(static_cast<uint32_t>(static_cast<int32_t>(ur.getX() * 1e7)), 4,
+            &h);
+    writeLe(static_cast<uint32_t>(static_cast<int32_t>(ur.getY() * 1e7)), 4,
+            &h);
+  }
+
+  writeLe(minZoom, 1, &h);
+  double cx = _numTiles ? (ll.getX() + ur.getX()) / 2 : 0;
+  double cy = _numTiles ? (ll.getY() + ur.getY()) / 2 : 0;
+  writeLe(static_cast<uint32_t>(static_cast<int32_t>(cx * 1e7)), 4, &h);
+  writeLe(static_cast<uint32_t>(static_cast<int32_t>(cy * 1e7)), 4, &h);
+
+  _f.seekp(0);
+  _f.write(h.data(), h.size());
+  _f.write(root.data(), root.size());
+  _f.close();
+
+  if (_f.fail()) throw std::runtime_error("Could not write to " + _path);
+}
+
+// _____________________________________________________________________________
+void PmTilesArchive::serializeDirs(const std::vector<Entry>& entries,
+                                   size_t maxRootSize, std::string* root,
+                                   std::string* leaves) {
+  *root = serializeDir(entries);
+  leaves->clear();
+
+  // if the root directory does not fit, the entries are distributed over
+  // leaf directories
+  for (size_t leafSize = 4096; root->size() > maxRootSize; leafSize *= 2) {
+    std::vector<Entry> rootEntries;
+    leaves->clear();
+
+    for (size_t i = 0; i < entries.size(); i += leafSize) {
+      std::vector<Entry> leaf(
+          entries.begin() + i,
+          entries.begin() + std::min(i + leafSize, entries.size()));
+      std::string dir = serializeDir(leaf);
+      rootEntries.push_back({leaf.front().tileId, leaves->size(),
+                             static_cast<uint32_t>(dir.size()), 0});
+      *leaves += dir;
+    }
+
+    *root = serializeDir(rootEntries);
+  }
+}
+
+// _____________________________________________________________________________
+std::string PmTilesArchive::serializeDir(const std::vector<Entry>& entries) {
+  std::string ret;
+
+  writeVarInt(entries.size(), &ret);
+
+  uint64_t lastId = 0;
+  for (const auto& e : entries) {
+    writeVarInt(e.tileId - lastId, &ret);
+    lastId = e.tileId;
+  }
+
+  for (const auto& e : entries) writeVarInt(e.runLength, &ret);
+  for (const auto& e : entries) writeVarInt(e.length, &ret);
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    // 0 marks data directly following the previous entry
+    if (i > 0 &&
+        entries[i].offset == entries[i - 1].offset + entries[i - 1].length) {
+      writeVarInt(0, &ret);
+    } else {
+      writeVarInt(entries[i].offset + 1, &ret);
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+uint64_t PmTilesArchive::tileId(size_t z, size_t x, size_t y) {
+  // number of tiles on all lower zoom levels
+  uint64_t acc = ((1ull << (2 * z)) - 1) / 3;
+
+  uint64_t n = 1ull << z;
+  uint64_t d = 0;
+  uint64_t tx = x, ty = y;
+
+  for (uint64_t s = n / 2; s > 0; s /= 2) {
+    uint64_t rx = (tx & s) > 0;
+    uint64_t ry = (ty & s) > 0;
+    d += s * s * ((3 * rx) ^ ry);
+
+    // rotate
+    if (ry == 0) {
+      if (rx == 1) {
+        tx = n - 1 - tx;
+        ty = n - 1 - ty;
+      }
+      std::swap(tx, ty);
+    }
+  }
+
+  return acc + d;
+}
+
+// _____________________________________________________________________________
+void PmTilesArchive::writeVarInt(uint64_t v, std::string* out) {
+  while (v >= 0x80) {
+    *out += static_cast<char>((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  *out += static_cast<char>(v);
+}
+
+// _____________________________________________________________________________
+void PmTilesArchive::writeLe(uint64_t v, size_t bytes, std::string* out) {
+  for (size_t i = 0; i < bytes; i++) {
+    *out += static_cast<char>(i < 8 ? (v >> (8 * i)) & 0xFF : 0);
+  }
+}
@@ -0,0 +1,76 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_PMTILESARCHIVE_H_
+#define TRANSITMAP_OUTPUT_PMTILESARCHIVE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "transitmap/output/TileArchive.h"
+
+namespace transitmapper {
+namespace output {
+
+// PMTiles v3 archive. Tile data is appended to the file as tiles are added,
+// the directories and the metadata are written on finish(). The header and
+// the root directory are written into space reserved at the start of the
+// file, the metadata and the leaf directories follow the tile data.
+class PmTilesArchive : public TileArchive {
+ public:
+  // a directory entry, run lengths of 0 point to leaf directories
+  struct Entry {
+    uint64_t tileId;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t runLength;
+  };
+
+  PmTilesArchive(const std::string& path, bool gzip);
+
+  // an archive which was not finished is removed
+  virtual ~PmTilesArchive();
+
+  virtual void finish();
+
+  // Hilbert curve tile id, y is counted from the north
+  static uint64_t tileId(size_t z, size_t x, size_t y);
+
+  static std::string serializeDir(const std::vector<Entry>& entries);
+
+  // serialize the directory of the sorted entries into root and, if the root
+  // directory would exceed maxRootSize bytes, distribute the entries over leaf
+  // directories written to leaves
+  static void serializeDirs(const std::vector<Entry>& entries,
+                            size_t maxRootSize, std::string* root,
+                            std::string* leaves);
+
+ protected:
+  virtual bool write(size_t z, size_t x, size_t y, const std::string& data);
+
+ private:
+  std::string _path;
+  std::fstream _f;
+
+  // bytes of tile data written
+  uint64_t _dataLen;
+
+  std::vector<Entry> _entries;
+
+  // content hash to the offsets of the tile data with this hash
+  std::unordered_multimap<uint64_t, Entry> _contents;
+
+  bool sameData(const Entry& e, const std::string& data);
+
+  static void writeVarInt(uint64_t v, std::string* out);
+  static void writeLe(uint64_t v, size_t bytes, std::string* out);
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_PMTILESARCHIVE_H_
@@ -3,15 +3,24 @@
 // Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
 
 #include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
 #include <fstream>
+#include <limits>
 #include <ostream>
+#include <sstream>
+#include <stdexcept>
 
 #include "shared/linegraph/Line.h"
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/label/Labeller.h"
 #include "transitmap/output/SvgRenderer.h"
+#include "util/Misc.h"
 #include "util/String.h"
 #include "util/geo/PolyLine.h"
 #include "util/log/Log.h"
@@ -23,20 +32,19 @@ using shared::rendergraph::RenderGraph;
 using transitmapper::label::Labeller;
 using transitmapper::output::InnerClique;
 using transitmapper::output::SvgRenderer;
+using util::geo::DBox;
 using util::geo::DPoint;
 using util::geo::DPolygon;
 using util::geo::LinePoint;
 using util::geo::LinePointCmp;
-using util::geo::Polygon;
 using util::geo::PolyLine;
 
 // _____________________________________________________________________________
 SvgRenderer::SvgRenderer(std::ostream* o, const config::Config* cfg)
-    : _o(o), _w(o, true), _cfg(cfg) {}
+    : _o(o), _w(o, cfg->svgPrecision), _cfg(cfg) {}
 
 // _____________________________________________________________________________
 void SvgRenderer::print(const RenderGraph& outG) {
-  std::map<std::string, std::string> params;
   RenderParams rparams;
 
   auto box = outG.getBBox();
@@ -78,6 +86,43 @@ void SvgRenderer::print(const RenderGraph& outG) {
   rparams.width *= _cfg->outputResolution;
   rparams.height *= _cfg->outputResolution;
 
+  LOGTO(DEBUG, std::cerr) << "Rendering edges...";
+  if (_cfg->renderEdges) {
+    outputEdges(outG);
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Rendering nodes...";
+  for (auto n : outG.getNds()) {
+    if (_cfg->renderNodeConnections) {
+      renderNodeConnections(outG, n);
+    }
+  }
+
+  outputNodes(outG);
+  if (_cfg->renderNodeFronts) {
+    renderNodeFronts(outG);
+  }
+
+  collectPrims();
+
+  if (_cfg->svgTileSize > 0) {
+    writeTiles(rparams, labeller);
+    return;
+  }
+
+  LOGTO(DEBUG, std::cerr) << "Writing SVG...";
+  _w.setTransform(rparams.xOff, rparams.yOff, rparams.height,
+                  _cfg->outputResolution);
+  writeSvg(&_w, rparams, labeller, box, 0, rparams.width, rparams.height, 0);
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::writeSvg(SvgWriter* w, const RenderParams& rparams,
+                           const Labeller& labeller, const DBox& box,
+                           const DBox* filter, double width, double height,
+                           double simplify) const {
+  std::map<std::string, std::string> params;
+
   auto latLngLL = util::geo::webMercToLatLng<double>(box.getLowerLeft().getX(),
                                                      box.getLowerLeft().getY());
   auto latLngUR = util::geo::webMercToLatLng<double>(
@@ -88,26 +133,30 @@ void SvgRenderer::print(const RenderGraph& outG) {
                          std::to_string(latLngUR.getX()) + "," +
                          std::to_string(latLngUR.getY());
 
-  params["width"] = std::to_string(rparams.width);
-  params["height"] = std::to_string(rparams.height);
-  params["viewBox"] = "0 0 " + std::to_string(rparams.width) + " " +
-                      std::to_string(rparams.height);
+  // the view box is given in the SVG coordinates of the full map
+  double res = _cfg->outputResolution;
+  double vx = (box.getLowerLeft().getX() - rparams.xOff) * res;
+  double vy =
+      rparams.height - (box.getUpperRight().getY() - rparams.yOff) * res;
+  double vw = (box.getUpperRight().getX() - box.getLowerLeft().getX()) * res;
+  double vh = (box.getUpperRight().getY() - box.getLowerLeft().getY()) * res;
+
+  params["width"] = std::to_string(width);
+  params["height"] = std::to_string(height);
+  params["viewBox"] = std::to_string(vx) + " " + std::to_string(vy) + " " +
+                      std::to_string(vw) + " " + std::to_string(vh);
   params["xmlns"] = "http://www.w3.org/2000/svg";
   params["xmlns:xlink"] = "http://www.w3.org/1999/xlink";
 
-  *_o << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-  *_o << "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" "
-         "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">";
+  w->writeRaw("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+  w->writeRaw(
+      "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" "
+      "\"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">");
 
-  LOGTO(DEBUG, std::cerr) << "Rendering edges...";
-  if (_cfg->renderEdges) {
-    outputEdges(outG, rparams);
-  }
-  _w.openTag("svg", params);
+  w->openTag("svg", params);
 
-  _w.openTag("defs");
+  w->openTag("defs");
 
-  LOGTO(DEBUG, std::cerr) << "Rendering markers...";
   for (auto const& m : _markers) {
     params.clear();
     params["id"] = m.name;
@@ -117,50 +166,143 @@ void SvgRenderer::print(const RenderGraph& outG) {
     params["refY"] = "0.5";
     params["refX"] = "0";
 
-    _w.openTag("marker", params);
+    w->openTag("marker", params);
 
     params.clear();
     params["d"] = m.path;
     params["fill"] = m.color;
-    ;
 
-    _w.openTag("path", params);
+    w->openTag("path", params);
 
-    _w.closeTag();
-    _w.closeTag();
+    w->closeTag();
+    w->closeTag();
   }
 
-  _w.closeTag();
+  w->closeTag();
 
-  LOGTO(DEBUG, std::cerr) << "Rendering nodes...";
-  for (auto n : outG.getNds()) {
-    if (_cfg->renderNodeConnections) {
-      renderNodeConnections(outG, n, rparams);
+  // primitives are written in document order, a group is only opened if it
+  // contains any primitive inside the filter box
+  size_t group = std::numeric_limits<size_t>::max();
+  for (size_t i : getInFilter(_primIdx, _prims.size(), filter)) {
+    const auto& prim = _prims[i];
+
+    if (prim.group != group) {
+      if (group != std::numeric_limits<size_t>::max()) w->closeTag();
+      w->openTag("g");
+      group = prim.group;
     }
-  }
 
-  LOGTO(DEBUG, std::cerr) << "Writing edges...";
-  renderDelegates(outG, rparams);
+    w->openTag("path");
+    for (const auto& kv : *prim.params) {
+      if (!prim.polygon || kv.first != "class") {
+        w->attr(kv.first.c_str(), kv.second);
+      }
+    }
 
-  LOGTO(DEBUG, std::cerr) << "Writing nodes...";
-  outputNodes(outG, rparams);
-  if (_cfg->renderNodeFronts) {
-    renderNodeFronts(outG, rparams);
+    if (prim.polygon) {
+      w->attr("class", "station-poly");
+      w->attrPath("d", *prim.geom, true);
+    } else if (simplify > 0) {
+      w->attrPath("d", util::geo::simplify(*prim.geom, simplify), false);
+    } else {
+      w->attrPath("d", *prim.geom, false);
+    }
+    w->closeTag();
   }
 
-  LOGTO(DEBUG, std::cerr) << "Writing labels...";
+  if (group != std::numeric_limits<size_t>::max()) w->closeTag();
+
   if (_cfg->renderLabels) {
-    renderLineLabels(labeller, rparams);
-    renderStationLabels(labeller, rparams);
+    renderLineLabels(w, labeller, filter);
+    renderStationLabels(w, labeller, filter);
+  }
+
+  w->closeTags();
+  w->flush();
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::writeTiles(const RenderParams& rparams,
+                             const Labeller& labeller) {
+  T_START(tiles);
+
+  double res = _cfg->outputResolution;
+  mkTileDir(_cfg->svgTilePath);
+
+  std::vector<SvgTile> tiles;
+
+  // the tiles of LOD level l cover 2^l times the area of a tile on level 0,
+  // scaled down to the same size
+  for (size_t lod = 0; lod < _cfg->svgLods; lod++) {
+    double ts = _cfg->svgTileSize * (1 << lod);
+    size_t nx = std::max(1.0, std::ceil(rparams.width / ts));
+    size_t ny = std::max(1.0, std::ceil(rparams.height / ts));
+
+    mkTileDir(_cfg->svgTilePath + "/" + std::to_string(lod));
+
+    for (size_t x = 0; x < nx; x++) {
+      for (size_t y = 0; y < ny; y++) tiles.push_back({lod, x, y});
+    }
+
+    // coarser levels would only repeat this single tile
+    if (nx == 1 && ny == 1) break;
+  }
+
+  buildTileIdx(labeller);
+
+  std::string err;
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < tiles.size(); i++) {
+    const auto& t = tiles[i];
+    double ts = _cfg->svgTileSize * (1 << t.lod);
+
+    // tile area in map coordinates, tile rows start at the top
+    double x0 = rparams.xOff + (t.x * ts) / res;
+    double y1 = rparams.yOff + (rparams.height - t.y * ts) / res;
+    DBox box(DPoint(x0, y1 - ts / res), DPoint(x0 + ts / res, y1));
+
+    std::string path = _cfg->svgTilePath + "/" + std::to_string(t.lod) + "/" +
+                       std::to_string(t.x) + "_" + std::to_string(t.y) +
+                       ".svg";
+
+    try {
+      std::ofstream fo(path, std::ios::out | std::ios::trunc);
+      if (!fo.is_open()) throw std::runtime_error("Could not open " + path);
+
+      SvgWriter w(&fo, _cfg->svgPrecision);
+      w.setTransform(rparams.xOff, rparams.yOff, rparams.height, res);
+
+      // geometries are simplified to a single output pixel of the level
+      writeSvg(&w, rparams, labeller, box, &box, _cfg->svgTileSize,
+               _cfg->svgTileSize, t.lod ? (1 << t.lod) / res : 0);
+    } catch (const std::exception& e) {
+#pragma omp critical
+      err = e.what();
+    }
   }
 
-  _w.closeTags();
+  if (!err.empty()) throw std::runtime_error(err);
+
+  double took = T_STOP(tiles);
+
+  if (_cfg->writeStats) {
+    LOGTO(INFO, std::cerr) << "Wrote " << tiles.size() << " SVG tiles in "
+                           << took << "ms";
+  }
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::mkTileDir(const std::string& path) const {
+  int err = mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+  if (err == -1 && errno != EEXIST) {
+    throw std::runtime_error("Could not create output directory " + path);
+  }
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::outputNodes(const RenderGraph& outG,
-                              const RenderParams& rparams) {
-  _w.openTag("g");
+void SvgRenderer::outputNodes(const RenderGraph& outG) {
   for (auto n : outG.getNds()) {
     std::map<std::string, std::string> params;
 
@@ -172,17 +314,14 @@ void SvgRenderer::outputNodes(const RenderGraph& outG,
       params["fill"] = "white";
 
       for (const auto& geom : outG.getStopGeoms(n, _cfg->tightStations, 32)) {
-        printPolygon(geom, params, rparams);
+        _stations.push_back({params, geom});
       }
     }
   }
-  _w.closeTag();
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::renderNodeFronts(const RenderGraph& outG,
-                                   const RenderParams& rparams) {
-  _w.openTag("g");
+void SvgRenderer::renderNodeFronts(const RenderGraph& outG) {
   for (auto n : outG.getNds()) {
     std::string color = n->pl().stops().size() > 0 ? "red" : "black";
     for (auto& f : n->pl().fronts()) {
@@ -193,7 +332,7 @@ void SvgRenderer::renderNodeFronts(const RenderGraph& outG,
                "miter;stroke-linecap:round;stroke-opacity:0.9;stroke-width:1";
       std::map<std::string, std::string> params;
       params["style"] = style.str();
-      printLine(p, params, rparams);
+      _fronts.push_back({params, p});
 
       DPoint a = p.getPointAt(.5).p;
 
@@ -203,15 +342,13 @@ void SvgRenderer::renderNodeFronts(const RenderGraph& outG,
                 "miter;stroke-linecap:round;stroke-opacity:1;stroke-width:.5";
       params["style"] = styleA.str();
 
-      printLine(PolyLine<double>(*n->pl().getGeom(), a), params, rparams);
+      _fronts.push_back({params, PolyLine<double>(*n->pl().getGeom(), a)});
     }
   }
-  _w.closeTag();
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::outputEdges(const RenderGraph& outG,
-                              const RenderParams& rparams) {
+void SvgRenderer::outputEdges(const RenderGraph& outG) {
   struct cmp {
     bool operator()(const LineNode* lhs, const LineNode* rhs) const {
       return lhs->getAdjList().size() > rhs->getAdjList().size() ||
@@ -242,16 +379,14 @@ void SvgRenderer::outputEdges(const RenderGraph& outG,
     edgesOrdered.insert(n->getAdjList().begin(), n->getAdjList().end());
 
     for (const auto* e : edgesOrdered) {
-      if (rendered.insert(e).second) renderEdgeTripGeom(outG, e, rparams);
+      if (rendered.insert(e).second) renderEdgeTripGeom(outG, e);
     }
   }
 }
 
 // _____________________________________________________________________________
 void SvgRenderer::renderNodeConnections(const RenderGraph& outG,
-                                        const LineNode* n,
-                                        const RenderParams& rparams) {
-  UNUSED(rparams);
+                                        const LineNode* n) {
   auto geoms = outG.innerGeoms(n, _cfg->innerGeometryPrecision);
 
   for (auto& clique : getInnerCliques(n, geoms, 9999)) renderClique(clique, n);
@@ -486,9 +621,7 @@ void SvgRenderer::renderLinePart(const PolyLine<double> p, double width,
 
 // _____________________________________________________________________________
 void SvgRenderer::renderEdgeTripGeom(const RenderGraph& outG,
-                                     const shared::linegraph::LineEdge* e,
-                                     const RenderParams& rparams) {
-  UNUSED(rparams);
+                                     const shared::linegraph::LineEdge* e) {
   const shared::linegraph::NodeFront* nfTo = e->getTo()->pl().frontFor(e);
   const shared::linegraph::NodeFront* nfFrom = e->getFrom()->pl().frontFor(e);
 
@@ -535,9 +668,9 @@ void SvgRenderer::renderEdgeTripGeom(const RenderGraph& outG,
 
     std::string css, oCss;
 
-    if (!lo.style.isNull()) {
-      css = lo.style.get().getCss();
-      oCss = lo.style.get().getOutlineCss();
+    if (lo.style) {
+      css = lo.style->getCss();
+      oCss = lo.style->getOutlineCss();
     }
 
     if (_cfg->renderDirMarkers && lo.direction != 0 &&
@@ -579,121 +712,88 @@ std::string SvgRenderer::getMarkerPathMale(double w) const {
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::renderDelegates(const RenderGraph& outG,
-                                  const RenderParams& rparams) {
-  UNUSED(outG);
+void SvgRenderer::addPrim(size_t group, const PrintDelegate& pd) {
+  // generous padding for strokes and direction markers
+  double pad = (_cfg->lineWidth + 2 * _cfg->outlineWidth) * 2;
+  _prims.push_back(
+      {group, &pd.first, &pd.second.getLine(), false,
+       util::geo::pad(util::geo::getBoundingBox(pd.second.getLine()), pad)});
+}
+
+// _____________________________________________________________________________
+void SvgRenderer::collectPrims() {
+  // all primitives have been collected, their storage does not change
+  // anymore
+  size_t group = 0;
+
   for (auto& a : _delegates) {
-    _w.openTag("g");
     for (auto& pd : a.second) {
-      if (_cfg->outlineWidth > 0) {
-        printLine(pd.back.second, pd.back.first, rparams);
-      }
-      printLine(pd.front.second, pd.front.first, rparams);
+      if (_cfg->outlineWidth > 0) addPrim(group, pd.back);
+      addPrim(group, pd.front);
     }
-    _w.closeTag();
+    group++;
   }
 
   for (auto& a : _innerDelegates) {
-    _w.openTag("g");
     for (auto& b : a) {
-      for (auto& pd : b.second) {
-        if (_cfg->outlineWidth > 0) {
-          printLine(pd.back.second, pd.back.first, rparams);
-        }
-      }
-      for (auto& pd : b.second) {
-        printLine(pd.front.second, pd.front.first, rparams);
+      if (_cfg->outlineWidth > 0) {
+        for (auto& pd : b.second) addPrim(group, pd.back);
       }
+      for (auto& pd : b.second) addPrim(group, pd.front);
     }
-    _w.closeTag();
+    group++;
   }
-}
 
-// _____________________________________________________________________________
-void SvgRenderer::printPoint(const DPoint& p, const std::string& style,
-                             const RenderParams& rparams) {
-  std::map<std::string, std::string> params;
-  params["cx"] =
-      std::to_string((p.getX() - rparams.xOff) * _cfg->outputResolution);
-  params["cy"] = std::to_string(rparams.height - (p.getY() - rparams.yOff) *
-                                                     _cfg->outputResolution);
-  params["r"] = "2";
-  params["style"] = style;
-  _w.openTag("circle", params);
-  _w.closeTag();
-}
+  for (const auto& st : _stations) {
+    _prims.push_back(
+        {group, &st.first, &st.second.getOuter(), true,
+         util::geo::pad(util::geo::getBoundingBox(st.second.getOuter()),
+                        _cfg->lineWidth)});
+  }
+  group++;
 
-// _____________________________________________________________________________
-void SvgRenderer::printLine(const PolyLine<double>& l, const std::string& style,
-                            const RenderParams& rparams) {
-  std::map<std::string, std::string> params;
-  params["style"] = style;
-  printLine(l, params, rparams);
+  for (const auto& pd : _fronts) addPrim(group, pd);
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::printLine(const PolyLine<double>& l,
-                            const std::map<std::string, std::string>& ps,
-                            const RenderParams& rparams) {
-  std::map<std::string, std::string> params = ps;
-  std::stringstream points;
-
-  for (auto& p : l.getLine()) {
-    points << " " << (p.getX() - rparams.xOff) * _cfg->outputResolution << ","
-           << rparams.height -
-                  (p.getY() - rparams.yOff) * _cfg->outputResolution;
+void SvgRenderer::buildTileIdx(const Labeller& labeller) {
+  // each tile only queries the primitives and labels it intersects
+  for (size_t i = 0; i < _prims.size(); i++) _primIdx.add(_prims[i].box, i);
+
+  const auto& statLbls = labeller.getStationLabels();
+  for (size_t i = 0; i < statLbls.size(); i++) {
+    _statLblIdx.add(
+        util::geo::pad(util::geo::getBoundingBox(statLbls[i].geom.getLine()),
+                       statLbls[i].fontSize),
+        i);
   }
 
-  params["points"] = points.str();
-
-  _w.openTag("polyline", params);
-  _w.closeTag();
+  const auto& lineLbls = labeller.getLineLabels();
+  for (size_t i = 0; i < lineLbls.size(); i++) {
+    _lineLblIdx.add(
+        util::geo::pad(util::geo::getBoundingBox(lineLbls[i].geom.getLine()),
+                       lineLbls[i].fontSize),
+        i);
+  }
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::printPolygon(const Polygon<double>& g,
-                               const std::map<std::string, std::string>& ps,
-                               const RenderParams& rparams) {
-  std::map<std::string, std::string> params = ps;
-  std::stringstream points;
-
-  for (auto& p : g.getOuter()) {
-    points << " " << (p.getX() - rparams.xOff) * _cfg->outputResolution << ","
-           << rparams.height -
-                  (p.getY() - rparams.yOff) * _cfg->outputResolution;
+std::vector<size_t> SvgRenderer::getInFilter(const SvgBoxIdx& idx, size_t n,
+                                             const DBox* filter) const {
+  std::vector<size_t> ret;
+
+  if (!filter) {
+    ret.resize(n);
+    for (size_t i = 0; i < n; i++) ret[i] = i;
+    return ret;
   }
 
-  params["points"] = points.str();
-  params["class"] = "station-poly";
-
-  _w.openTag("polygon", params);
-  _w.closeTag();
-}
-
-// _____________________________________________________________________________
-void SvgRenderer::printCircle(const DPoint& center, double rad,
-                              const std::string& style,
-                              const RenderParams& rparams) {
-  std::map<std::string, std::string> params;
-  params["style"] = style;
-  printCircle(center, rad, params, rparams);
-}
+  // ordered, to keep the document order
+  std::set<size_t> found;
+  idx.get(*filter, &found);
+  ret.assign(found.begin(), found.end());
 
-// _____________________________________________________________________________
-void SvgRenderer::printCircle(const DPoint& center, double rad,
-                              const std::map<std::string, std::string>& ps,
-                              const RenderParams& rparams) {
-  std::map<std::string, std::string> params = ps;
-  std::stringstream points;
-
-  params["cx"] =
-      std::to_string((center.getX() - rparams.xOff) * _cfg->outputResolution);
-  params["cy"] = std::to_string(
-      rparams.height - (center.getY() - rparams.yOff) * _cfg->outputResolution);
-  params["r"] = std::to_string(rad * _cfg->outputResolution);
-
-  _w.openTag("circle", params);
-  _w.closeTag();
+  return ret;
 }
 
 // _____________________________________________________________________________
@@ -710,11 +810,12 @@ size_t InnerClique::getNumBranchesIn(
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::renderStationLabels(const Labeller& labeller,
-                                      const RenderParams& rparams) {
-  _w.openTag("g");
-  size_t id = 0;
-  for (auto label : labeller.getStationLabels()) {
+void SvgRenderer::renderStationLabels(SvgWriter* w, const Labeller& labeller,
+                                      const DBox* filter) const {
+  w->openTag("g");
+  const auto& labels = labeller.getStationLabels();
+  for (size_t id : getInFilter(_statLblIdx, labels.size(), filter)) {
+    const auto& label = labels[id];
     std::string shift = "0em";
     std::string textAnchor = "start";
     std::string startOffset = "0";
@@ -728,32 +829,14 @@ void SvgRenderer::renderStationLabels(const Labeller& labeller,
       textPath.reverse();
     }
 
-    std::stringstream points;
-    std::map<std::string, std::string> pathPars;
-
-    points << "M"
-           << (textPath.front().getX() - rparams.xOff) * _cfg->outputResolution
-           << " "
-           << rparams.height - (textPath.front().getY() - rparams.yOff) *
-                                   _cfg->outputResolution;
-
-    for (auto& p : textPath.getLine()) {
-      points << " L" << (p.getX() - rparams.xOff) * _cfg->outputResolution
-             << " "
-             << rparams.height -
-                    (p.getY() - rparams.yOff) * _cfg->outputResolution;
-    }
-
     std::string idStr = "stlblp" + util::toString(id);
 
-    pathPars["d"] = points.str();
-    pathPars["id"] = idStr;
-    id++;
-
-    _w.openTag("defs");
-    _w.openTag("path", pathPars);
-    _w.closeTag();
-    _w.closeTag();
+    w->openTag("defs");
+    w->openTag("path");
+    w->attrPath("d", textPath.getLine(), false);
+    w->attr("id", idStr);
+    w->closeTag();
+    w->closeTag();
 
     std::map<std::string, std::string> params;
     params["class"] = "station-label";
@@ -763,25 +846,26 @@ void SvgRenderer::renderStationLabels(const Labeller& labeller,
     params["font-size"] =
         util::toString(label.fontSize * _cfg->outputResolution);
 
-    _w.openTag("text", params);
-    _w.openTag("textPath", {{"dy", shift},
+    w->openTag("text", params);
+    w->openTag("textPath", {{"dy", shift},
                             {"xlink:href", "#" + idStr},
                             {"startOffset", startOffset},
                             {"text-anchor", textAnchor}});
 
-    _w.writeText(label.s.name);
-    _w.closeTag();
-    _w.closeTag();
+    w->writeText(label.s.name);
+    w->closeTag();
+    w->closeTag();
   }
-  _w.closeTag();
+  w->closeTag();
 }
 
 // _____________________________________________________________________________
-void SvgRenderer::renderLineLabels(const Labeller& labeller,
-                                   const RenderParams& rparams) {
-  _w.openTag("g");
-  size_t id = 0;
-  for (auto label : labeller.getLineLabels()) {
+void SvgRenderer::renderLineLabels(SvgWriter* w, const Labeller& labeller,
+                                   const DBox* filter) const {
+  w->openTag("g");
+  const auto& labels = labeller.getLineLabels();
+  for (size_t id : getInFilter(_lineLblIdx, labels.size(), filter)) {
+    const auto& label = labels[id];
     std::string shift = "0em";
     auto textPath = label.geom;
     double ang = util::geo::angBetween(textPath.front(), textPath.back());
@@ -791,32 +875,14 @@ void SvgRenderer::renderLineLabels(const Labeller& labeller,
       textPath.reverse();
     }
 
-    std::stringstream points;
-    std::map<std::string, std::string> pathPars;
-
-    points << "M"
-           << (textPath.front().getX() - rparams.xOff) * _cfg->outputResolution
-           << " "
-           << rparams.height - (textPath.front().getY() - rparams.yOff) *
-                                   _cfg->outputResolution;
-
-    for (auto& p : textPath.getLine()) {
-      points << " L" << (p.getX() - rparams.xOff) * _cfg->outputResolution
-             << " "
-             << rparams.height -
-                    (p.getY() - rparams.yOff) * _cfg->outputResolution;
-    }
-
     std::string idStr = "textp" + util::toString(id);
 
-    pathPars["d"] = points.str();
-    pathPars["id"] = idStr;
-    id++;
-
-    _w.openTag("defs");
-    _w.openTag("path", pathPars);
-    _w.closeTag();
-    _w.closeTag();
+    w->openTag("defs");
+    w->openTag("path");
+    w->attrPath("d", textPath.getLine(), false);
+    w->attr("id", idStr);
+    w->closeTag();
+    w->closeTag();
 
     std::map<std::string, std::string> params;
     params["class"] = "line-label";
@@ -826,24 +892,24 @@ void SvgRenderer::renderLineLabels(const Labeller& labeller,
     params["font-size"] =
         util::toString(label.fontSize * _cfg->outputResolution);
 
-    _w.openTag("text", params);
-    _w.openTag("textPath", {{"dy", shift},
+    w->openTag("text", params);
+    w->openTag("textPath", {{"dy", shift},
                             {"xlink:href", "#" + idStr},
                             {"text-anchor", "middle"},
                             {"startOffset", "50%"}});
 
     double dy = 0;
     for (auto line : label.lines) {
-      _w.openTag("tspan",
-                 {{"fill", "#" + line->color()}, {"dx", util::toString(dy)}});
+      w->openTag("tspan",
+                  {{"fill", "#" + line->color()}, {"dx", util::toString(dy)}});
       dy = (label.fontSize * _cfg->outputResolution) / 3;
-      _w.writeText(line->label());
-      _w.closeTag();
+      w->writeText(line->label());
+      w->closeTag();
     }
-    _w.closeTag();
-    _w.closeTag();
+    w->closeTag();
+    w->closeTag();
   }
-  _w.closeTag();
+  w->closeTag();
 }
 
 // _____________________________________________________________________________
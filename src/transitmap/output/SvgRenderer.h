@@ -14,9 +14,10 @@
 #include "shared/rendergraph/RenderGraph.h"
 #include "transitmap/config/TransitMapConfig.h"
 #include "transitmap/label/Labeller.h"
+#include "transitmap/output/SvgWriter.h"
 #include "util/geo/Geo.h"
 #include "util/geo/PolyLine.h"
-#include "util/xml/XmlWriter.h"
+#include "util/geo/RTree.h"
 
 using util::Nullable;
 
@@ -33,6 +34,26 @@ struct EndMarker {
   double width, height;
 };
 
+struct SvgTile {
+  // level of detail, tiles on level l cover 2^l times the area of level 0
+  size_t lod;
+  size_t x, y;
+};
+
+// a single path written to the SVG, referencing the collected geometries
+struct SvgPrimitive {
+  // consecutive primitives with the same group are written into one <g>
+  size_t group;
+  const Params* params;
+  const util::geo::Line<double>* geom;
+  bool polygon;
+  // bounding box, including the stroke width
+  util::geo::DBox box;
+};
+
+// bounding boxes of primitives or labels, by their index
+typedef util::geo::RTree<size_t, util::geo::Box, double> SvgBoxIdx;
+
 class SvgRenderer : public Renderer {
  public:
   SvgRenderer(std::ostream* o, const config::Config* cfg);
@@ -40,25 +61,9 @@ class SvgRenderer : public Renderer {
 
   virtual void print(const shared::rendergraph::RenderGraph& outputGraph);
 
-  void printLine(const util::geo::PolyLine<double>& l,
-                 const std::map<std::string, std::string>& ps,
-                 const RenderParams& params);
-  void printLine(const util::geo::PolyLine<double>& l, const std::string& style,
-                 const RenderParams& params);
-  void printPoint(const util::geo::DPoint& p, const std::string& style,
-                  const RenderParams& params);
-  void printPolygon(const util::geo::Polygon<double>& g,
-                    const std::map<std::string, std::string>& ps,
-                    const RenderParams& params);
-  void printCircle(const util::geo::DPoint& center, double rad,
-                   const std::map<std::string, std::string>& ps,
-                   const RenderParams& rparams);
-  void printCircle(const util::geo::DPoint& center, double rad,
-                   const std::string& style, const RenderParams& rparams);
-
  private:
   std::ostream* _o;
-  util::xml::XmlWriter _w;
+  SvgWriter _w;
 
   const config::Config* _cfg;
 
@@ -66,21 +71,27 @@ class SvgRenderer : public Renderer {
   std::vector<std::map<uintptr_t, std::vector<OutlinePrintPair>>>
       _innerDelegates;
   std::vector<EndMarker> _markers;
+  std::vector<std::pair<Params, util::geo::DPolygon>> _stations;
+  std::vector<PrintDelegate> _fronts;
+
+  // all primitives in document order
+  std::vector<SvgPrimitive> _prims;
+
+  // spatial indices over the primitives and labels, only built for tiles
+  SvgBoxIdx _primIdx;
+  SvgBoxIdx _statLblIdx;
+  SvgBoxIdx _lineLblIdx;
   mutable std::map<std::string, int> lineClassIds;
   mutable int lineClassId = 0;
 
-  void outputNodes(const shared::rendergraph::RenderGraph& outputGraph,
-                   const RenderParams& params);
-  void outputEdges(const shared::rendergraph::RenderGraph& outputGraph,
-                   const RenderParams& params);
+  void outputNodes(const shared::rendergraph::RenderGraph& outputGraph);
+  void outputEdges(const shared::rendergraph::RenderGraph& outputGraph);
 
   void renderEdgeTripGeom(const shared::rendergraph::RenderGraph& outG,
-                          const shared::linegraph::LineEdge* e,
-                          const RenderParams& params);
+                          const shared::linegraph::LineEdge* e);
 
   void renderNodeConnections(const shared::rendergraph::RenderGraph& outG,
-                             const shared::linegraph::LineNode* n,
-                             const RenderParams& params);
+                             const shared::linegraph::LineNode* n);
 
   void renderLinePart(const util::geo::PolyLine<double> p, double width,
                       const shared::linegraph::Line& line,
@@ -93,17 +104,36 @@ class SvgRenderer : public Renderer {
                       const std::string& oCss,
                       const std::string& endMarker);
 
-  void renderDelegates(const shared::rendergraph::RenderGraph& outG,
-                       const RenderParams& params);
+  void addPrim(size_t group, const PrintDelegate& pd);
+  void collectPrims();
+  void buildTileIdx(const label::Labeller& labeller);
+
+  // indices of all entries of idx inside filter in ascending order, or all
+  // n indices if filter is not set
+  std::vector<size_t> getInFilter(const SvgBoxIdx& idx, size_t n,
+                                  const util::geo::DBox* filter) const;
+
+  // write the area box of the map as a standalone SVG of the given size.
+  // If filter is set, only primitives and labels intersecting it are
+  // written, this requires buildTileIdx(). If simplify is > 0, lines are
+  // simplified with it.
+  void writeSvg(SvgWriter* w, const RenderParams& rparams,
+                const label::Labeller& labeller, const util::geo::DBox& box,
+                const util::geo::DBox* filter, double width, double height,
+                double simplify) const;
+
+  // write the map as a grid of SVG tiles, on all LOD levels
+  void writeTiles(const RenderParams& rparams,
+                  const label::Labeller& labeller);
+  void mkTileDir(const std::string& path) const;
 
-  void renderNodeFronts(const shared::rendergraph::RenderGraph& outG,
-                        const RenderParams& params);
+  void renderNodeFronts(const shared::rendergraph::RenderGraph& outG);
 
-  void renderLineLabels(const label::Labeller& lbler,
-                        const RenderParams& params);
+  void renderLineLabels(SvgWriter* w, const label::Labeller& lbler,
+                        const util::geo::DBox* filter) const;
 
-  void renderStationLabels(const label::Labeller& lbler,
-                           const RenderParams& params);
+  void renderStationLabels(SvgWriter* w, const label::Labeller& lbler,
+                           const util::geo::DBox* filter) const;
 
   std::multiset<InnerClique> getInnerCliques(
       const shared::linegraph::LineNode* n,
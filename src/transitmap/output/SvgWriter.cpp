@@ -0,0 +1,291 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <cstdio>
+
+#include "transitmap/output/SvgWriter.h"
+
+using transitmapper::output::SvgWriter;
+
+// buffered output is written to the stream in chunks of this size
+static const size_t BUF_SIZE = 1 << 16;
+
+// _____________________________________________________________________________
+SvgWriter::SvgWriter(std::ostream* out, int prec)
+    : _out(out),
+      _tagOpen(false),
+      _prec(prec),
+      _scale(1),
+      _xOff(0),
+      _yOff(0),
+      _height(0),
+      _res(1) {
+  for (int i = 0; i < _prec; i++) _scale *= 10;
+  _buf.reserve(BUF_SIZE + 1024);
+}
+
+// _____________________________________________________________________________
+SvgWriter::~SvgWriter() {
+  closeTags();
+  flush();
+}
+
+// _____________________________________________________________________________
+void SvgWriter::setTransform(double xOff, double yOff, double height,
+                             double res) {
+  _xOff = xOff;
+  _yOff = yOff;
+  _height = height;
+  _res = res;
+}
+
+// _____________________________________________________________________________
+void SvgWriter::openTag(const char* tag) {
+  endStartTag();
+  _buf += '<';
+  _buf += tag;
+  _stack.push_back(tag);
+  _tagOpen = true;
+}
+
+// _____________________________________________________________________________
+void SvgWriter::openTag(const char* tag,
+                        const std::map<std::string, std::string>& attrs) {
+  openTag(tag);
+  for (const auto& kv : attrs) attr(kv.first.c_str(), kv.second);
+}
+
+// _____________________________________________________________________________
+void SvgWriter::attr(const char* key, const std::string& val) {
+  _buf += ' ';
+  _buf += key;
+  _buf += "=\"";
+  writeEscaped(val);
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void SvgWriter::attr(const char* key, double val) {
+  _buf += ' ';
+  _buf += key;
+  _buf += "=\"";
+  if (_prec < 0) {
+    writeNum(val);
+  } else {
+    writeFixed(quant(val));
+  }
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void SvgWriter::attrPoint(const char* keyX, const char* keyY,
+                          const util::geo::DPoint& p) {
+  _buf += ' ';
+  _buf += keyX;
+  _buf += "=\"";
+  if (_prec < 0) {
+    writeNum((p.getX() - _xOff) * _res);
+  } else {
+    writeFixed(quantX(p.getX()));
+  }
+  _buf += "\" ";
+  _buf += keyY;
+  _buf += "=\"";
+  if (_prec < 0) {
+    writeNum(_height - (p.getY() - _yOff) * _res);
+  } else {
+    writeFixed(quantY(p.getY()));
+  }
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void SvgWriter::attrPath(const char* key, const util::geo::Line<double>& line,
+                         bool closed) {
+  _buf += ' ';
+  _buf += key;
+  _buf += "=\"";
+
+  if (_prec < 0) {
+    // unquantized coordinates are written as absolute values, relative moves
+    // would accumulate the rounding errors
+    for (size_t i = 0; i < line.size(); i++) {
+      _buf += i ? " L" : "M";
+      writeNum((line[i].getX() - _xOff) * _res);
+      _buf += ' ';
+      writeNum(_height - (line[i].getY() - _yOff) * _res);
+    }
+    if (closed && line.size()) _buf += 'z';
+  } else if (line.size()) {
+    int64_t x = quantX(line[0].getX());
+    int64_t y = quantY(line[0].getY());
+
+    _buf += 'M';
+    writeFixed(x);
+    if (y >= 0) _buf += ' ';
+    writeFixed(y);
+
+    bool rel = false;
+
+    for (size_t i = 1; i < line.size(); i++) {
+      int64_t nx = quantX(line[i].getX());
+      int64_t ny = quantY(line[i].getY());
+      if (nx == x && ny == y) continue;
+
+      // negative numbers need no separator
+      if (!rel) {
+        _buf += 'l';
+        rel = true;
+      } else if (nx - x >= 0) {
+        _buf += ' ';
+      }
+      writeFixed(nx - x);
+      if (ny - y >= 0) _buf += ' ';
+      writeFixed(ny - y);
+
+      x = nx;
+      y = ny;
+    }
+
+    if (closed) _buf += 'z';
+  }
+
+  _buf += '"';
+}
+
+// _____________________________________________________________________________
+void SvgWriter::writeText(const std::string& text) {
+  endStartTag();
+  writeEscaped(text);
+}
+
+// _____________________________________________________________________________
+void SvgWriter::writeRaw(const std::string& raw) {
+  endStartTag();
+  _buf += raw;
+}
+
+// _____________________________________________________________________________
+void SvgWriter::closeTag() {
+  if (_stack.empty()) return;
+
+  if (_tagOpen) {
+    _buf += "/>";
+    _tagOpen = false;
+  } else {
+    _buf += "</";
+    _buf += _stack.back();
+    _buf += '>';
+  }
+
+  _stack.pop_back();
+
+  // line breaks between elements on the top levels only
+  if (_stack.size() < 3) _buf += '\n';
+
+  checkFlush();
+}
+
+// _____________________________________________________________________________
+void SvgWriter::closeTags() {
+  while (!_stack.empty()) closeTag();
+}
+
+// _____________________________________________________________________________
+void SvgWriter::flush() {
+  _out->write(_buf.data(), _buf.size());
+  _out->flush();
+  _buf.clear();
+}
+
+// _____________________________________________________________________________
+void SvgWriter::checkFlush() {
+  if (_buf.size() < BUF_SIZE) return;
+  _out->write(_buf.data(), _buf.size());
+  _buf.clear();
+}
+
+// _____________________________________________________________________________
+void SvgWriter::endStartTag() {
+  if (!_tagOpen) return;
+  _buf += '>';
+  _tagOpen = false;
+}
+
+// _____________________________________________________________________________
+void SvgWriter::writeEscaped(const std::string& s) {
+  for (char c : s) {
+    switch (c) {
+      case '&':
+        _buf += "&amp;";
+        break;
+      case '<':
+        _buf += "&lt;";
+        break;
+      case '>':
+        _buf += "&gt;";
+        break;
+      case '"':
+        _buf += "&quot;";
+        break;
+      case '\'':
+        _buf += "&apos;";
+        break;
+      default:
+        _buf += c;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+int64_t SvgWriter::quant(double v) const {
+  return std::llround(v * static_cast<double>(_scale));
+}
+
+// _____________________________________________________________________________
+int64_t SvgWriter::quantX(double x) const { return quant((x - _xOff) * _res); }
+
+// _____________________________________________________________________________
+int64_t SvgWriter::quantY(double y) const {
+  return quant(_height - (y - _yOff) * _res);
+}
+
+// _____________________________________________________________________________
+void SvgWriter::writeFixed(int64_t q) {
+  // q is a value in units of 10^-_prec, trailing zeros of the decimal places
+  // are dropped
+  uint64_t v = q < 0 ? -static_cast<uint64_t>(q) : q;
+  if (q < 0) _buf += '-';
+
+  char tmp[20];
+  size_t n = 0;
+  uint64_t intPart = v / _scale;
+  do {
+    tmp[n++] = static_cast<char>('0' + intPart % 10);
+    intPart /= 10;
+  } while (intPart);
+  while (n) _buf += tmp[--n];
+
+  uint64_t frac = v % _scale;
+  if (!frac) return;
+
+  char digs[20];
+  for (int i = _prec; i > 0; i--) {
+    digs[i - 1] = static_cast<char>('0' + frac % 10);
+    frac /= 10;
+  }
+  size_t len = _prec;
+  while (digs[len - 1] == '0') len--;
+  _buf += '.';
+  _buf.append(digs, len);
+}
+
+// _____________________________________________________________________________
+void SvgWriter::writeNum(double v) {
+  // same as the default formatting of output streams
+  char tmp[32];
+  int n = snprintf(tmp, sizeof(tmp), "%g", v);
+  _buf.append(tmp, n);
+}
@@ -0,0 +1,89 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_SVGWRITER_H_
+#define TRANSITMAP_OUTPUT_SVGWRITER_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "util/geo/Geo.h"
+
+namespace transitmapper {
+namespace output {
+
+// Buffered streaming SVG output. Attributes are written directly into the
+// output buffer, coordinates are transformed into the SVG coordinate system
+// and written without going through string streams. Optionally, coordinates
+// are quantized to a fixed number of decimal places.
+class SvgWriter {
+ public:
+  // if prec >= 0, coordinates are quantized to prec decimal places and paths
+  // are written with relative moves. Otherwise, coordinates are written
+  // unquantized with 6 significant digits.
+  SvgWriter(std::ostream* out, int prec);
+  ~SvgWriter();
+
+  // map coordinates (x, y) are written as ((x - xOff) * res,
+  // height - (y - yOff) * res)
+  void setTransform(double xOff, double yOff, double height, double res);
+
+  void openTag(const char* tag);
+  void openTag(const char* tag,
+               const std::map<std::string, std::string>& attrs);
+
+  // attributes of the last opened tag, before any content was written
+  void attr(const char* key, const std::string& val);
+  void attr(const char* key, double val);
+
+  // a transformed point as two attributes
+  void attrPoint(const char* keyX, const char* keyY,
+                 const util::geo::DPoint& p);
+
+  // a transformed line as SVG path data. If quantized, moves are relative
+  // and consecutive points identical after quantization are dropped
+  void attrPath(const char* key, const util::geo::Line<double>& line,
+                bool closed);
+
+  void writeText(const std::string& text);
+
+  // unescaped content, for example the XML declaration
+  void writeRaw(const std::string& raw);
+
+  // close the innermost open tag
+  void closeTag();
+  void closeTags();
+
+  // write the buffer to the stream
+  void flush();
+
+ private:
+  std::ostream* _out;
+  std::string _buf;
+  std::vector<std::string> _stack;
+  bool _tagOpen;
+
+  int _prec;
+  int64_t _scale;
+
+  double _xOff, _yOff, _height, _res;
+
+  void endStartTag();
+  void writeEscaped(const std::string& s);
+  void writeFixed(int64_t q);
+  void writeNum(double v);
+  int64_t quant(double v) const;
+  int64_t quantX(double x) const;
+  int64_t quantY(double y) const;
+  void checkFlush();
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_SVGWRITER_H_
@@ -0,0 +1,102 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#ifdef ZLIB_FOUND
+#include <zlib.h>
+#endif
+
+#include "transitmap/output/TileArchive.h"
+
+using transitmapper::output::TileArchive;
+using util::geo::DPoint;
+
+// _____________________________________________________________________________
+TileArchive::TileArchive(bool gzip)
+    : _gzip(gzip),
+      _minZoom(std::numeric_limits<size_t>::max()),
+      _maxZoom(0),
+      _numTiles(0),
+      _numContents(0) {
+#ifndef ZLIB_FOUND
+  if (_gzip)
+    throw std::runtime_error(
+        "transitmap was not compiled with zlib, cannot gzip tiles");
+#endif
+}
+
+// _____________________________________________________________________________
+std::string TileArchive::encode(const std::string& tile) const {
+  if (!_gzip) return tile;
+
+#ifdef ZLIB_FOUND
+  z_stream zs;
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+
+  // window bits 15 + 16 for a gzip header
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    throw std::runtime_error("Could not initialize gzip compression");
+
+  std::string ret(deflateBound(&zs, tile.size()), 0);
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(tile.data()));
+  zs.avail_in = tile.size();
+  zs.next_out = reinterpret_cast<Bytef*>(&ret[0]);
+  zs.avail_out = ret.size();
+
+  int err = deflate(&zs, Z_FINISH);
+  ret.resize(zs.total_out);
+  deflateEnd(&zs);
+
+  if (err != Z_STREAM_END) throw std::runtime_error("Could not gzip tile");
+
+  return ret;
+#else
+  return tile;
+#endif
+}
+
+// _____________________________________________________________________________
+void TileArchive::add(size_t z, size_t x, size_t y, const std::string& data) {
+  if (write(z, x, y, data)) _numContents++;
+  _numTiles++;
+
+  if (z < _minZoom) _minZoom = z;
+  if (z > _maxZoom) _maxZoom = z;
+
+  // tile corners in lat/lng
+  double n = 1 << z;
+  double lngW = x / n * 360.0 - 180.0;
+  double lngE = (x + 1) / n * 360.0 - 180.0;
+  double latS = atan(sinh(M_PI * (2.0 * y / n - 1))) * 180.0 / M_PI;
+  double latN = atan(sinh(M_PI * (2.0 * (y + 1) / n - 1))) * 180.0 / M_PI;
+
+  _bounds = util::geo::extendBox(DPoint(lngW, latS), _bounds);
+  _bounds = util::geo::extendBox(DPoint(lngE, latN), _bounds);
+}
+
+// _____________________________________________________________________________
+std::string TileArchive::vectorLayersJson() const {
+  return "{\"vector_layers\":["
+         "{\"id\":\"inner-connections\",\"fields\":{}},"
+         "{\"id\":\"lines\",\"fields\":{}},"
+         "{\"id\":\"stations\",\"fields\":{}}]}";
+}
+
+// _____________________________________________________________________________
+uint64_t TileArchive::hash(const std::string& data) {
+  // 64 bit FNV-1a
+  uint64_t h = 14695981039346656037ull;
+  for (char c : data) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
@@ -0,0 +1,59 @@
+// Copyright 2016, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+// Authors: Patrick Brosi <brosi@informatik.uni-freiburg.de>
+
+#ifndef TRANSITMAP_OUTPUT_TILEARCHIVE_H_
+#define TRANSITMAP_OUTPUT_TILEARCHIVE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "util/geo/Geo.h"
+
+namespace transitmapper {
+namespace output {
+
+// Single-file container for vector tiles of multiple zoom levels. Tiles are
+// appended in the order they are added, identical tiles are only stored
+// once.
+class TileArchive {
+ public:
+  explicit TileArchive(bool gzip);
+  virtual ~TileArchive() {}
+
+  // compress serialized tile data if gzip compression is enabled, may be
+  // called concurrently
+  std::string encode(const std::string& tile) const;
+
+  // add an encoded tile, y is counted from the south as in TMS. Not thread
+  // safe.
+  void add(size_t z, size_t x, size_t y, const std::string& data);
+
+  // write the tile index and the metadata and close the archive
+  virtual void finish() = 0;
+
+  size_t numTiles() const { return _numTiles; }
+  size_t numContents() const { return _numContents; }
+
+ protected:
+  bool _gzip;
+
+  size_t _minZoom, _maxZoom;
+  size_t _numTiles, _numContents;
+
+  // covered area, in lat/lng
+  util::geo::DBox _bounds;
+
+  // returns true if data was stored as a new content
+  virtual bool write(size_t z, size_t x, size_t y, const std::string& data) = 0;
+
+  // the vector layers written by MvtRenderer
+  std::string vectorLayersJson() const;
+
+  static uint64_t hash(const std::string& data);
+};
+
+}  // namespace output
+}  // namespace transitmapper
+
+#endif  // TRANSITMAP_OUTPUT_TILEARCHIVE_H_
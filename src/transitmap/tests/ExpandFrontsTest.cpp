@@ -0,0 +1,201 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+#include "shared/linegraph/Line.h"
+#include "shared/rendergraph/RenderGraph.h"
+#include "transitmap/config/TransitMapConfig.h"
+#include "transitmap/graph/GraphBuilder.h"
+#include "transitmap/tests/ExpandFrontsTest.h"
+#include "util/Misc.h"
+#include "util/geo/PolyLine.h"
+
+using shared::linegraph::Line;
+using shared::linegraph::LineEdge;
+using shared::linegraph::LineNode;
+using shared::linegraph::NodeFront;
+using shared::rendergraph::RenderGraph;
+using transitmapper::graph::GraphBuilder;
+using util::geo::DPoint;
+using util::geo::PolyLine;
+
+const static double MINL = 10;
+
+// _____________________________________________________________________________
+std::set<NodeFront*> overlappingFronts(const RenderGraph* g, LineNode* n) {
+  // the overlap test of the original expansion, for nodes without stations
+  std::set<NodeFront*> ret;
+
+  for (size_t i = 0; i < n->pl().fronts().size(); ++i) {
+    NodeFront& fa = n->pl().fronts()[i];
+
+    for (size_t j = i + 1; j < n->pl().fronts().size(); ++j) {
+      NodeFront& fb = n->pl().fronts()[j];
+
+      if (fa.geom.equals(fb.geom, 5)) continue;
+
+      double maxNfDist = 2 * g->getMaxNdFrontWidth(n);
+
+      size_t numShr = RenderGraph::getSharedLines(fa.edge, fb.edge).size();
+      double fac = 5;
+      if (!numShr) fac = 1;
+
+      bool overlap = fb.geom.distTo(fa.geom) <=
+                     (g->getWidth(fa.edge) + 2 * g->getOutlineWidth(fa.edge) +
+                      g->getSpacing(fa.edge)) *
+                         fac;
+
+      if (overlap) {
+        if (util::geo::len(*fa.edge->pl().getGeom()) > MINL &&
+            fa.geom.distTo(*n->pl().getGeom()) < maxNfDist) {
+          ret.insert(&fa);
+        }
+        if (util::geo::len(*fb.edge->pl().getGeom()) > MINL &&
+            fb.geom.distTo(*n->pl().getGeom()) < maxNfDist) {
+          ret.insert(&fb);
+        }
+      }
+    }
+  }
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void expandStepwise(RenderGraph* g) {
+  // the original expansion, which shrinks the overlapping fronts of all
+  // nodes by a single step per pass until nothing overlaps anymore
+  double step =
+      (g->getWidth(0) + g->getSpacing(0) + 2 * g->getOutlineWidth(0)) / 10;
+
+  while (true) {
+    bool stillFree = false;
+    for (auto n : g->getNds()) {
+      for (auto f : overlappingFronts(g, n)) {
+        stillFree = true;
+        double len = util::geo::len(*f->edge->pl().getGeom());
+
+        if (f->edge->getTo() == n) {
+          double d = fmax(MINL - 1, len - step);
+          f->geom = PolyLine<double>(*f->edge->pl().getGeom())
+                        .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
+
+          f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
+                                    .getSegmentAtDist(0, d)
+                                    .getLine());
+        } else {
+          double d = fmin(step, len - MINL + 1);
+          f->geom = PolyLine<double>(*f->edge->pl().getGeom())
+                        .getOrthoLineAtDist(d, g->getTotalWidth(f->edge));
+
+          f->edge->pl().setGeom(PolyLine<double>(*f->edge->pl().getGeom())
+                                    .getSegmentAtDist(d, len)
+                                    .getLine());
+
+          f->geom.reverse();
+        }
+      }
+    }
+    if (!stillFree) break;
+  }
+}
+
+// _____________________________________________________________________________
+void buildFixture(RenderGraph* g, Line* l1, Line* l2, Line* l3) {
+  //    a           e
+  //     \         /
+  // c -- x ------ y
+  //     /|         \ f
+  //    b d
+  auto x = g->addNd({{0.0, 0.0}});
+  auto y = g->addNd({{3000.0, 0.0}});
+  auto a = g->addNd({{-1000.0, 400.0}});
+  auto b = g->addNd({{-1000.0, -400.0}});
+  auto c = g->addNd({{-1000.0, 0.0}});
+  auto d = g->addNd({{0.0, -1000.0}});
+  auto e = g->addNd({{4000.0, 300.0}});
+  auto f = g->addNd({{4000.0, -300.0}});
+
+  auto xa = g->addEdg(x, a, {{{0.0, 0.0}, {-1000.0, 400.0}}});
+  auto bx = g->addEdg(b, x, {{{-1000.0, -400.0}, {0.0, 0.0}}});
+  auto xc = g->addEdg(x, c, {{{0.0, 0.0}, {-1000.0, 0.0}}});
+  auto xd = g->addEdg(x, d, {{{0.0, 0.0}, {0.0, -1000.0}}});
+  auto xy = g->addEdg(x, y, {{{0.0, 0.0}, {3000.0, 0.0}}});
+  auto ye = g->addEdg(y, e, {{{3000.0, 0.0}, {4000.0, 300.0}}});
+  auto fy = g->addEdg(f, y, {{{4000.0, -300.0}, {3000.0, 0.0}}});
+
+  xa->pl().addLine(l1, 0);
+  xa->pl().addLine(l3, 0);
+  bx->pl().addLine(l1, 0);
+  xc->pl().addLine(l2, 0);
+  xd->pl().addLine(l1, 0);
+  xd->pl().addLine(l2, 0);
+  xy->pl().addLine(l1, 0);
+  ye->pl().addLine(l1, 0);
+  fy->pl().addLine(l2, 0);
+}
+
+// _____________________________________________________________________________
+void ExpandFrontsTest::run() {
+  {
+    // the worklist expansion yields the same fronts as the step-wise one
+    transitmapper::config::Config cfg;
+    GraphBuilder builder(&cfg);
+
+    Line l1("1", "1", "red");
+    Line l2("2", "2", "blue");
+    Line l3("3", "3", "green");
+
+    RenderGraph ref(20, 1, 10);
+    RenderGraph g(20, 1, 10);
+    buildFixture(&ref, &l1, &l2, &l3);
+    buildFixture(&g, &l1, &l2, &l3);
+
+    builder.writeNodeFronts(&ref);
+    builder.writeNodeFronts(&g);
+
+    expandStepwise(&ref);
+    builder.expandOverlappinFronts(&g);
+
+    // nodes are matched by their position, fronts by the position of the
+    // other node of their edge
+    std::map<std::pair<double, double>, const LineNode*> refNds;
+    for (auto n : ref.getNds()) {
+      refNds[{n->pl().getGeom()->getX(), n->pl().getGeom()->getY()}] = n;
+    }
+
+    size_t shrunk = 0;
+
+    for (auto n : g.getNds()) {
+      auto rn = refNds[{n->pl().getGeom()->getX(), n->pl().getGeom()->getY()}];
+      TEST(rn != 0);
+      TEST(n->pl().fronts().size(), ==, rn->pl().fronts().size());
+
+      for (const auto& f : n->pl().fronts()) {
+        const auto& other = *f.edge->getOtherNd(n)->pl().getGeom();
+        const NodeFront* rf = 0;
+        for (const auto& cand : rn->pl().fronts()) {
+          if (util::geo::dist(*cand.edge->getOtherNd(rn)->pl().getGeom(),
+                              other) < 0.001) {
+            rf = &cand;
+          }
+        }
+        TEST(rf != 0);
+
+        TEST(util::geo::dist(f.geom.front(), rf->geom.front()), <, 0.001);
+        TEST(util::geo::dist(f.geom.back(), rf->geom.back()), <, 0.001);
+        TEST(util::geo::len(*f.edge->pl().getGeom()), ==,
+             util::approx(util::geo::len(*rf->edge->pl().getGeom())));
+
+        if (util::geo::dist(f.geom.front(), f.origGeom.front()) > 0.001)
+          shrunk++;
+      }
+    }
+
+    // the fixture actually requires expansion
+    TEST(shrunk > 0);
+  }
+}
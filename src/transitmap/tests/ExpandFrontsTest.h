@@ -0,0 +1,12 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#ifndef TRANSITMAP_TEST_EXPANDFRONTSTEST_H_
+#define TRANSITMAP_TEST_EXPANDFRONTSTEST_H_
+
+class ExpandFrontsTest {
+  public:
+    void run();
+};
+
+#endif
@@ -0,0 +1,141 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#include <string>
+#include <vector>
+#include "transitmap/output/PmTilesArchive.h"
+#include "transitmap/tests/PmTilesArchiveTest.h"
+#include "util/Misc.h"
+
+using transitmapper::output::PmTilesArchive;
+
+// _____________________________________________________________________________
+uint64_t readVarInt(const std::string& s, size_t* pos) {
+  uint64_t ret = 0;
+  for (size_t shift = 0; *pos < s.size(); shift += 7) {
+    unsigned char c = s[(*pos)++];
+    ret |= static_cast<uint64_t>(c & 0x7F) << shift;
+    if (!(c & 0x80)) break;
+  }
+  return ret;
+}
+
+// _____________________________________________________________________________
+std::vector<PmTilesArchive::Entry> readDir(const std::string& s) {
+  size_t pos = 0;
+  std::vector<PmTilesArchive::Entry> ret(readVarInt(s, &pos));
+
+  uint64_t lastId = 0;
+  for (auto& e : ret) {
+    e.tileId = lastId + readVarInt(s, &pos);
+    lastId = e.tileId;
+  }
+  for (auto& e : ret) e.runLength = readVarInt(s, &pos);
+  for (auto& e : ret) e.length = readVarInt(s, &pos);
+  for (size_t i = 0; i < ret.size(); i++) {
+    uint64_t off = readVarInt(s, &pos);
+    if (off == 0 && i > 0) {
+      ret[i].offset = ret[i - 1].offset + ret[i - 1].length;
+    } else {
+      ret[i].offset = off - 1;
+    }
+  }
+
+  TEST(pos, ==, s.size());
+
+  return ret;
+}
+
+// _____________________________________________________________________________
+void PmTilesArchiveTest::run() {
+  {
+    // tile ids from the PMTiles v3 specification
+    TEST(PmTilesArchive::tileId(0, 0, 0), ==, 0);
+    TEST(PmTilesArchive::tileId(1, 0, 0), ==, 1);
+    TEST(PmTilesArchive::tileId(1, 0, 1), ==, 2);
+    TEST(PmTilesArchive::tileId(1, 1, 1), ==, 3);
+    TEST(PmTilesArchive::tileId(1, 1, 0), ==, 4);
+    TEST(PmTilesArchive::tileId(2, 0, 0), ==, 5);
+    TEST(PmTilesArchive::tileId(3, 0, 0), ==, 21);
+    TEST(PmTilesArchive::tileId(4, 0, 0), ==, 85);
+
+    // the ids of a zoom level are a permutation of a consecutive range
+    std::vector<bool> seen(16, false);
+    for (size_t x = 0; x < 4; x++) {
+      for (size_t y = 0; y < 4; y++) {
+        uint64_t id = PmTilesArchive::tileId(2, x, y);
+        TEST(id >= 5 && id < 21);
+        TEST(!seen[id - 5]);
+        seen[id - 5] = true;
+      }
+    }
+  }
+
+  {
+    // directory with consecutive data, a run and a varint above 127
+    std::vector<PmTilesArchive::Entry> entries{
+        {0, 0, 10, 1}, {1, 10, 20, 1}, {5, 100, 300, 2}};
+
+    std::string dir = PmTilesArchive::serializeDir(entries);
+    std::string exp{3,  0, 1, 4, 1, 1, 2, 10, 20, static_cast<char>(0xAC),
+                    2,  1, 0, 101};
+    TEST(dir == exp);
+
+    auto read = readDir(dir);
+    TEST(read.size(), ==, 3);
+    TEST(read[2].tileId, ==, 5);
+    TEST(read[2].offset, ==, 100);
+    TEST(read[2].length, ==, 300);
+    TEST(read[2].runLength, ==, 2);
+  }
+
+  {
+    // small directories stay in the root
+    std::vector<PmTilesArchive::Entry> entries;
+    for (uint64_t i = 0; i < 100; i++) entries.push_back({i, i * 10, 10, 1});
+
+    std::string root, leaves;
+    PmTilesArchive::serializeDirs(entries, 16384, &root, &leaves);
+    TEST(root == PmTilesArchive::serializeDir(entries));
+    TEST(leaves.empty());
+  }
+
+  {
+    // large directories are split into leaf directories, referenced from the
+    // root by entries with a run length of 0
+    std::vector<PmTilesArchive::Entry> entries;
+    for (uint64_t i = 0; i < 10000; i++) {
+      entries.push_back({i * 2, i * 10, 10, 1});
+    }
+
+    std::string root, leaves;
+    PmTilesArchive::serializeDirs(entries, 100, &root, &leaves);
+    TEST(root.size() <= 100);
+
+    auto rootEntries = readDir(root);
+    TEST(rootEntries.size(), ==, 3);
+
+    size_t n = 0;
+    for (size_t i = 0; i < rootEntries.size(); i++) {
+      const auto& re = rootEntries[i];
+      TEST(re.runLength, ==, 0);
+      TEST(re.tileId, ==, entries[n].tileId);
+      TEST(re.offset + re.length <= leaves.size());
+
+      // leaf directories are written back to back
+      if (i == 0) TEST(re.offset, ==, 0);
+
+      auto leaf = readDir(leaves.substr(re.offset, re.length));
+      for (const auto& e : leaf) {
+        TEST(e.tileId, ==, entries[n].tileId);
+        TEST(e.offset, ==, entries[n].offset);
+        TEST(e.length, ==, entries[n].length);
+        TEST(e.runLength, ==, entries[n].runLength);
+        n++;
+      }
+    }
+    TEST(n, ==, entries.size());
+    TEST(rootEntries.back().offset + rootEntries.back().length, ==,
+         leaves.size());
+  }
+}
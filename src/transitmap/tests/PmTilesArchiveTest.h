@@ -0,0 +1,12 @@
+// Copyright 2016
+// Author: Patrick Brosi
+
+#ifndef TRANSITMAP_TEST_PMTILESARCHIVETEST_H_
+#define TRANSITMAP_TEST_PMTILESARCHIVETEST_H_
+
+class PmTilesArchiveTest {
+  public:
+    void run();
+};
+
+#endif
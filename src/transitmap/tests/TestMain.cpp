@@ -1,12 +1,18 @@
 // Copyright 2016
 // Author: Patrick Brosi
 
+#include "transitmap/tests/ExpandFrontsTest.h"
+#include "transitmap/tests/PmTilesArchiveTest.h"
+
 #include "util/Misc.h"
 
 // _____________________________________________________________________________
 int main(int argc, char** argv) {
   UNUSED(argc);
   UNUSED(argv);
+  ExpandFrontsTest eft;
+  PmTilesArchiveTest pmt;
 
-  return 0;
+  eft.run();
+  pmt.run();
 }